@@ -23,34 +23,6 @@
 
 #include "SVGNativeCWrapper.h"
 
-char* read_svg_input(const char* pathname)
-{
-    char*   buff_input;
-    FILE*   file_input;
-    size_t  size_input;
-
-    file_input = fopen(pathname, "r");
-    if (!file_input)
-    {
-        printf("Error! Could not open input file.");
-        exit(EXIT_FAILURE);
-    }
-
-    fseek(file_input, 0, SEEK_END);
-    size_input = ftell(file_input);
-    fseek(file_input, 0, SEEK_SET);
-    buff_input = malloc(size_input + 1);
-    if (!buff_input)
-    {
-        printf("Error! Cannot allocate sufficient memory to read input SVG.");
-        exit(EXIT_FAILURE);
-    }
-    fread(buff_input, size_input, 1, file_input);
-    fclose(file_input);
-
-    return buff_input;
-}
-
 size_t write_data(const char* pathname, const char* buff_output, size_t size_output)
 {
     FILE*   file_output;
@@ -73,7 +45,6 @@ int main(int argc, const char* argv[])
     svg_native_t*  sn;
     svg_native_color_map_t*  colorMap;
 
-    char*   buff_input;
     char*   buff_output;
     size_t  size_output;
 
@@ -82,14 +53,17 @@ int main(int argc, const char* argv[])
         printf("Incorrect number of arguments.");
         return 0;
     }
-    buff_input = read_svg_input(argv[1]);
-
     colorMap = svg_native_color_map_create();
     svg_native_color_map_add(colorMap, "test-red",   0.502,   0.0, 0.0, 1.0);
     svg_native_color_map_add(colorMap, "test-green",   0.0, 0.502, 0.0, 1.0);
     svg_native_color_map_add(colorMap, "test-blue",    0.0,   0.0, 1.0, 1.0);
 
-    sn = svg_native_create(SVG_RENDERER_STRING, buff_input);
+    sn = svg_native_create_from_file(SVG_RENDERER_STRING, argv[1]);
+    if (!sn)
+    {
+        printf("Error! Could not read input file.");
+        exit(EXIT_FAILURE);
+    }
     svg_native_set_color_map(sn, colorMap);
 
     svg_native_render(sn);
@@ -128,20 +128,14 @@ int main(int argc, char* const argv[])
         return 0;
     }
 
-    std::string svgInput{};
-    std::ifstream input(argv[1]);
-    if (!input)
+    auto renderer = std::make_shared<SVGNative::CairoSVGRenderer>();
+
+    auto doc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(argv[1], renderer);
+    if (!doc)
     {
-        std::cerr << "Error! Could not open input file." << std::endl;
+        std::cerr << "Error! Could not read input file." << std::endl;
         exit(EXIT_FAILURE);
     }
-    for (std::string line; std::getline(input, line);)
-        svgInput.append(line);
-    input.close();
-
-    auto renderer = std::make_shared<SVGNative::CairoSVGRenderer>();
-
-    auto doc = std::unique_ptr<SVGNative::SVGDocument>(SVGNative::SVGDocument::CreateSVGDocument(svgInput.c_str(), renderer));
 
     cairo_rectangle_t docExtents{ 0, 0, 0, 0 };
     docExtents.width = doc->Width();
@@ -17,12 +17,239 @@
  **************************************************************************/
 
 #include "SVGDocument.h"
+#include "SVGDocumentCache.h"
+#include "SVGStreamingParser.h"
 #include "StringSVGRenderer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <vector>
 
+static std::string ReadFile(const char* path)
+{
+    std::ifstream inputStream(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(inputStream), std::istreambuf_iterator<char>());
+}
+
+static const char* ParseResultName(SVGNative::ParseResult result)
+{
+    switch (result)
+    {
+    case SVGNative::ParseResult::kSuccess: return "kSuccess";
+    case SVGNative::ParseResult::kInvalidDocument: return "kInvalidDocument";
+    case SVGNative::ParseResult::kElementLimit: return "kElementLimit";
+    case SVGNative::ParseResult::kUseDepthLimit: return "kUseDepthLimit";
+    case SVGNative::ParseResult::kUseExpansionLimit: return "kUseExpansionLimit";
+    case SVGNative::ParseResult::kPathSegmentLimit: return "kPathSegmentLimit";
+    case SVGNative::ParseResult::kImageSizeLimit: return "kImageSizeLimit";
+    case SVGNative::ParseResult::kTimeLimit: return "kTimeLimit";
+    case SVGNative::ParseResult::kDepthLimit: return "kDepthLimit";
+    }
+    return "unknown";
+}
+
+// Renders the document or the element with the given id the way the expected output
+// gets rendered. renderer must be the one the document was created with.
+static std::string RenderToString(SVGNative::SVGDocument* doc, SVGNative::StringSVGRenderer& renderer, const char* id,
+    const SVGNative::ColorMap& colorMap)
+{
+    if (!doc)
+        return "No document\n";
+    if (id)
+        doc->Render(id, colorMap);
+    else
+        doc->Render(colorMap);
+    return renderer.String();
+}
+
+// Renders the parts of the document in visibleArea, once with Render() and once with
+// RenderTo() to a new renderer. Returns an error instead if the two differ.
+// doc must have been created with renderer and ParseOptions::computeBounds.
+static std::string RenderVisible(SVGNative::SVGDocument* doc, SVGNative::StringSVGRenderer& renderer,
+    const SVGNative::Rect& visibleArea, const SVGNative::ColorMap& colorMap)
+{
+    if (!doc)
+        return "No document\n";
+    auto width = static_cast<float>(doc->Width());
+    auto height = static_cast<float>(doc->Height());
+    doc->Render(visibleArea, colorMap, width, height);
+    SVGNative::StringSVGRenderer otherRenderer;
+    doc->RenderTo(otherRenderer, visibleArea, doc->CompileColorMap(colorMap), width, height);
+    if (otherRenderer.String() != renderer.String())
+        return "RenderTo() with a visible area differs\n";
+    return renderer.String();
+}
+
+// Parses the file with the given options and renders it like the expected output.
+static std::string RenderWithOptions(const char* path, const char* id, const SVGNative::ColorMap& colorMap,
+    const SVGNative::ParseOptions& options)
+{
+    auto renderer = std::make_shared<SVGNative::StringSVGRenderer>();
+    auto doc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(path, renderer, options);
+    return RenderToString(doc.get(), *renderer, id, colorMap);
+}
+
+// Renders doc with RenderTo() to a new renderer like the expected output.
+static std::string RenderToNewRenderer(const SVGNative::SVGDocument* doc, const char* id, const SVGNative::ColorMap& colorMap)
+{
+    if (!doc)
+        return "No document\n";
+    SVGNative::StringSVGRenderer renderer;
+    auto width = static_cast<float>(doc->Width());
+    auto height = static_cast<float>(doc->Height());
+    if (id)
+        doc->RenderTo(renderer, id, colorMap, width, height);
+    else
+        doc->RenderTo(renderer, colorMap, width, height);
+    return renderer.String();
+}
+
+// Like RenderWithOptions() but draws with RenderTo() to a renderer other than the one
+// the document was created with.
+static std::string RenderToWithOptions(const char* path, const char* id, const SVGNative::ColorMap& colorMap,
+    const SVGNative::ParseOptions& options)
+{
+    auto doc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(
+        path, std::make_shared<SVGNative::StringSVGRenderer>(), options);
+    return RenderToNewRenderer(doc.get(), id, colorMap);
+}
+
+// Like RenderWithOptions() but with the color map compiled for the document.
+static std::string RenderCompiled(const char* path, const char* id, const SVGNative::ColorMap& colorMap,
+    const SVGNative::ParseOptions& options)
+{
+    auto renderer = std::make_shared<SVGNative::StringSVGRenderer>();
+    auto doc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(path, renderer, options);
+    if (!doc)
+        return "No document\n";
+    auto compiledColorMap = doc->CompileColorMap(colorMap);
+    if (id)
+        doc->Render(id, compiledColorMap);
+    else
+        doc->Render(compiledColorMap);
+    return renderer->String();
+}
+
+// Gets the document from an SVGDocumentCache twice, from different copies of content,
+// and renders the cached document. Returns an error instead if the second call parsed
+// again or a document with other content got returned.
+static std::string RenderCached(const std::string& content, const char* id, const SVGNative::ColorMap& colorMap)
+{
+    SVGNative::SVGDocumentCache cache(64 * 1024 * 1024);
+    auto renderer = std::make_shared<SVGNative::StringSVGRenderer>();
+    auto doc = cache.GetDocument(content.data(), content.size(), renderer);
+    auto copy = content;
+    if (cache.GetDocument(copy.data(), copy.size(), renderer) != doc)
+        return "Parsed again\n";
+    copy += ' ';
+    if (doc && cache.GetDocument(copy.data(), copy.size(), renderer) == doc)
+        return "Got the document of other content\n";
+    return RenderToNewRenderer(doc.get(), id, colorMap);
+}
+
+// True if CreateFromBinary() rejects every truncated copy of binary. Tries all lengths of
+// short documents and about 2000 lengths of longer ones.
+static bool RejectsTruncated(const std::vector<char>& binary)
+{
+    auto step = std::max<size_t>(binary.size() / 1024, 1);
+    for (size_t length = 0; length < binary.size(); length += length < 1024 ? 1 : step)
+    {
+        if (SVGNative::SVGDocument::CreateFromBinary(binary.data(), length, std::make_shared<SVGNative::StringSVGRenderer>()))
+            return false;
+    }
+    return !SVGNative::SVGDocument::CreateFromBinary(
+        binary.data(), binary.size() - 1, std::make_shared<SVGNative::StringSVGRenderer>());
+}
+
+// Feeds the content to SVGStreamingParser in chunks of chunkSize bytes.
+static std::string RenderStreamed(const std::string& content, size_t chunkSize, const char* id, const SVGNative::ColorMap& colorMap)
+{
+    auto renderer = std::make_shared<SVGNative::StringSVGRenderer>();
+    SVGNative::SVGStreamingParser parser(renderer);
+    for (size_t pos = 0; pos < content.size(); pos += chunkSize)
+    {
+        if (!parser.Feed(content.data() + pos, std::min(chunkSize, content.size() - pos)))
+            break;
+    }
+    auto doc = parser.Finish();
+    return RenderToString(doc.get(), *renderer, id, colorMap);
+}
+
+// Creates and renders the document in every other supported way. Each of them must give
+// the same output as the plain parser. Returns a line for every way that did not.
+static std::string CheckConsistency(const char* path, const char* id, const SVGNative::ColorMap& colorMap, const std::string& expected)
+{
+    std::string mismatches;
+    auto check = [&](const std::string& output, const char* what) {
+        if (output != expected)
+            mismatches += std::string("Mismatch: ") + what + "\n";
+    };
+
+    SVGNative::ParseOptions threadOptions;
+    threadOptions.pathThreadCount = 4;
+    check(RenderWithOptions(path, id, colorMap, threadOptions), "parsing paths on 4 threads");
+
+    SVGNative::ParseOptions deduplicateOptions;
+    deduplicateOptions.deduplicatePaths = true;
+    check(RenderWithOptions(path, id, colorMap, deduplicateOptions), "deduplicating paths");
+
+    SVGNative::ParseOptions serializableOptions;
+    serializableOptions.isSerializable = true;
+    auto serializableDoc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(
+        path, std::make_shared<SVGNative::StringSVGRenderer>(), serializableOptions);
+    auto binary = serializableDoc ? serializableDoc->Serialize() : std::vector<char>();
+    if (binary.empty())
+        mismatches += "Mismatch: serializing\n";
+    else
+    {
+        auto binaryRenderer = std::make_shared<SVGNative::StringSVGRenderer>();
+        auto binaryDoc = SVGNative::SVGDocument::CreateFromBinary(binary.data(), binary.size(), binaryRenderer);
+        check(RenderToString(binaryDoc.get(), *binaryRenderer, id, colorMap), "rendering a serialized document");
+        if (!RejectsTruncated(binary))
+            mismatches += "Mismatch: truncated serialized document\n";
+    }
+
+    check(RenderCompiled(path, id, colorMap, SVGNative::ParseOptions()), "compiled color map");
+
+    if (!id)
+    {
+        // Nothing is outside of this area, so nothing may get skipped.
+        SVGNative::ParseOptions boundsOptions;
+        boundsOptions.computeBounds = true;
+        auto boundsRenderer = std::make_shared<SVGNative::StringSVGRenderer>();
+        auto boundsDoc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(path, boundsRenderer, boundsOptions);
+        SVGNative::Rect visibleArea{-1.0e30f, -1.0e30f, 2.0e30f, 2.0e30f};
+        check(RenderVisible(boundsDoc.get(), *boundsRenderer, visibleArea, colorMap), "rendering with a visible area around everything");
+    }
+
+    // Render(id) builds only the element with the id, everything else builds the whole document.
+    SVGNative::ParseOptions lazyOptions;
+    lazyOptions.isLazy = true;
+    check(RenderWithOptions(path, id, colorMap, lazyOptions), "lazy parsing");
+    check(RenderToWithOptions(path, id, colorMap, lazyOptions), "RenderTo() on a lazy document");
+    check(RenderCompiled(path, id, colorMap, lazyOptions), "compiled color map on a lazy document");
+
+    auto content = ReadFile(path);
+
+    // Chunks of one byte split every token, chunks of 7 bytes split tokens at varying offsets.
+    check(RenderStreamed(content, 1, id, colorMap), "streaming in chunks of 1 byte");
+    check(RenderStreamed(content, 7, id, colorMap), "streaming in chunks of 7 bytes");
+    check(RenderStreamed(content, content.size(), id, colorMap), "streaming in one chunk");
+
+    check(RenderCached(content, id, colorMap), "SVGDocumentCache");
+
+    return mismatches;
+}
+
+// Usage: testSVGNative input output [id | --limits | --cull]
+// Renders the document, or the element with the given id, and checks that all other
+// ways to create and render it agree. --limits parses with limits set and prints the
+// ParseResult if one of them was hit. --cull renders only the elements that are
+// visible in the top left quarter of the document.
 int main(int argc, char* const argv[])
 {
     if (argc != 3 && argc != 4)
@@ -31,17 +258,6 @@ int main(int argc, char* const argv[])
         return 0;
     }
 
-    std::string svgInput{};
-    std::ifstream input(argv[1]);
-    if (!input)
-    {
-        std::cout << "Error! Could not open input file." << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    for (std::string line; std::getline(input, line);)
-        svgInput.append(line);
-    input.close();
-
     SVGNative::ColorMap colorMap = {
         {"test-red",   {{0.502,   0.0, 0.0, 1.0}}},
         {"test-green", {{  0.0, 0.502, 0.0, 1.0}}},
@@ -49,13 +265,41 @@ int main(int argc, char* const argv[])
     };
     auto renderer = std::make_shared<SVGNative::StringSVGRenderer>();
 
-    auto doc = std::unique_ptr<SVGNative::SVGDocument>(SVGNative::SVGDocument::CreateSVGDocument(svgInput.c_str(), renderer));
-    if (argc == 3)
-        doc->Render(colorMap);
+    std::string mode{argc == 4 && std::strncmp(argv[3], "--", 2) == 0 ? argv[3] : ""};
+    SVGNative::ParseOptions options;
+    if (mode == "--limits")
+    {
+        options.limits.maxElements = 100000;
+        options.limits.maxUseExpansions = 100000;
+        options.limits.timeLimit = 1000;
+        options.limits.maxDepth = 256;
+    }
+    else if (mode == "--cull")
+        options.computeBounds = true;
+
+    const char* id = argc == 4 && mode.empty() ? argv[3] : nullptr;
+
+    std::string outputString;
+    SVGNative::ParseResult result{};
+    auto doc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(argv[1], renderer, options, &result);
+    if (doc)
+    {
+        if (mode == "--cull")
+        {
+            SVGNative::Rect visibleArea{0, 0, doc->Width() / 2.0f, doc->Height() / 2.0f};
+            outputString = RenderVisible(doc.get(), *renderer, visibleArea, colorMap);
+        }
+        else
+            outputString = RenderToString(doc.get(), *renderer, id, colorMap);
+        if (mode.empty())
+            outputString += CheckConsistency(argv[1], id, colorMap, outputString);
+    }
+    else if (mode == "--limits" && result != SVGNative::ParseResult::kInvalidDocument)
+        outputString = std::string{"ParseResult: "} + ParseResultName(result) + "\n";
     else
     {
-        std::string id{argv[3]};
-        doc->Render(id.c_str(), colorMap);
+        std::cout << "Error! Could not read input file." << std::endl;
+        exit(EXIT_FAILURE);
     }
 
     std::fstream outputStream;
@@ -65,7 +309,6 @@ int main(int argc, char* const argv[])
         std::cout << "Error! Could not write file." << std::endl;
         exit(EXIT_FAILURE);
     }
-    std::string outputString{renderer->String()};
     outputStream << outputString;
     outputStream.close();
 
@@ -16,6 +16,7 @@ governing permissions and limitations under the License.
 #include "Config.h"
 
 #include <array>
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
@@ -32,22 +33,207 @@ namespace SVGNative
 {
 class SVGDocumentImpl;
 class SVGRenderer;
+struct Rect;
 using ColorMap = std::map<std::string, std::array<float, 4>>;
 
+/**
+ * A ColorMap resolved against the variable names of one document, see
+ * SVGDocument::CompileColorMap(). Rendering with it looks up colors by index instead
+ * of by name. A compiled map of another document renders the fallback colors of all
+ * variables. Default constructed maps behave like an empty ColorMap.
+ */
+class SVG_IMP_EXP CompiledColorMap
+{
+private:
+    friend class SVGDocument;
+    friend class SVGDocumentImpl;
+
+    // Colors by variable slot of the document.
+    std::vector<std::array<float, 4>> mColors;
+    std::vector<bool> mHasColor;
+    // Colors for names the document had no slot for when the map was compiled.
+    ColorMap mColorMap;
+    const SVGDocumentImpl* mDocument{};
+};
+
+/**
+ * Outcome of creating an SVG document.
+ */
+enum class ParseResult
+{
+    kSuccess,
+    /** The data could not be read or is not well-formed XML. */
+    kInvalidDocument,
+    /** One of the ParseLimits was exceeded. */
+    kElementLimit,
+    kUseDepthLimit,
+    kUseExpansionLimit,
+    kPathSegmentLimit,
+    kImageSizeLimit,
+    kTimeLimit,
+    kDepthLimit
+};
+
+/**
+ * Upper bounds for the work spent on parsing untrusted documents. Parsing stops as soon
+ * as a limit is exceeded and no document gets created. A value of 0 disables the limit.
+ * Lazy documents apply the limits to every pass that builds elements later. An element
+ * that exceeds them does not get built.
+ */
+struct ParseLimits
+{
+    /** Number of elements, counting every copy instantiated through <use>. */
+    size_t maxElements = 0;
+
+    /** Nesting depth of <use> elements that reference content with <use> elements. */
+    unsigned int maxUseDepth = 0;
+
+    /** Number of times the content of <use> elements gets instantiated. */
+    size_t maxUseExpansions = 0;
+
+    /** Number of segments of all path, polygon and polyline outlines together. */
+    size_t maxPathSegments = 0;
+
+    /** Memory needed by all embedded images together once decoded, in bytes. */
+    size_t maxImageSize = 0;
+
+    /** Wall-clock time for parsing in milliseconds. */
+    unsigned int timeLimit = 0;
+
+    /**
+     * Nesting depth of XML elements, the root element being at depth 1. Gets checked
+     * before the XML is parsed. Parsing deeply nested documents without this limit
+     * may exhaust the stack.
+     */
+    unsigned int maxDepth = 0;
+};
+
+/**
+ * Options that control how an SVG document gets parsed. The defaults parse the
+ * whole document on the calling thread.
+ */
+struct ParseOptions
+{
+    /**
+     * Number of threads that parse the "d" and "points" attributes of path, polygon and
+     * polyline elements. The calling thread counts as one of them. Values of 0 and 1 parse
+     * serially. The resulting document is identical in either case.
+     */
+    unsigned int pathThreadCount = 0;
+
+    /**
+     * Builds the render tree on demand. Parsing only indexes the ids of shapes, groups,
+     * images and <use> elements and reads gradients, clipping paths and styles. An element
+     * gets built on the first Render(id) call for its id. Render() without an id builds
+     * the whole document. The XML content is kept in memory until then. Resources are
+     * resolved against the whole document, so references to resources that get defined
+     * later in the document resolve as well.
+     */
+    bool isLazy = false;
+
+    /**
+     * Embedded images get decoded by the renderer when they are drawn the first time.
+     * Decoded images that were not drawn recently get released once all decoded images
+     * together take more than this number of bytes. They are decoded again when needed.
+     * 0 keeps all decoded images.
+     */
+    size_t imageCacheSize = 0;
+
+    /**
+     * Shapes with exactly the same outline share one Path object of the renderer,
+     * regardless of their style. Saves memory on documents that repeat geometry and
+     * lets renderers reuse data they cache per Path. Costs a hash lookup per shape.
+     */
+    bool deduplicatePaths = false;
+
+    /**
+     * Keeps the outlines and transformation matrices of the render tree next to the
+     * objects of the renderer. Required by SVGDocument::Serialize(). Costs about as much
+     * memory as the paths of the renderer.
+     */
+    bool isSerializable = false;
+
+    /**
+     * Keeps conservative bounds of all paths and the transformation matrices of the
+     * render tree, so that Render() with a visible area can skip the elements outside
+     * of it. Costs 16 bytes per path plus the memory of the matrices. The bounds of
+     * the elements get computed on the first such rendering.
+     */
+    bool computeBounds = false;
+
+    /**
+     * Limits for documents from untrusted sources. The defaults do not limit anything.
+     */
+    ParseLimits limits;
+};
+
 class SVG_IMP_EXP SVGDocument
 {
 public:
     /**
-     * Parses the passed string as SVG.
-     * @param s SVG content as string.
+     * Parses the passed string as SVG. The string is never modified.
+     * @param s SVG content as NUL-terminated string.
      * @param renderer The renderer provides the Transform, Shape and Path interface needed at parse time and
      *      the actual renderer used during rendering process.
      * @return Returns a pointer to a new SVGDocument object.
      */
     static std::unique_ptr<SVGDocument> CreateSVGDocument(const char* s, std::shared_ptr<SVGNative::SVGRenderer> renderer);
 
+    /**
+     * Parses the passed buffer as SVG. The buffer is never modified and does not need to
+     * be NUL-terminated. It may live in read-only or shared memory and can be released
+     * as soon as this function returns. If the last byte in the buffer is NUL, the
+     * buffer is parsed directly. Otherwise it gets copied once to add the terminator.
+     * @param data SVG content. Should be UTF8 encoded.
+     * @param length Number of bytes in data.
+     * @param renderer The renderer provides the Transform, Shape and Path interface needed at parse time and
+     *      the actual renderer used during rendering process.
+     * @param options Options that control the parsing.
+     * @param result Optional. Receives the reason if no document was created.
+     * @return Returns a pointer to a new SVGDocument object. May be nullptr on error.
+     */
+    static std::unique_ptr<SVGDocument> CreateSVGDocument(const char* data, size_t length, std::shared_ptr<SVGNative::SVGRenderer> renderer,
+        const ParseOptions& options = ParseOptions(), ParseResult* result = nullptr);
+
+    /**
+     * Maps the file at the passed path into memory and parses it as SVG. The file
+     * is never modified and gets unmapped before this function returns.
+     * @param path File system path to an SVG document. Should be UTF8 encoded.
+     * @param renderer The renderer provides the Transform, Shape and Path interface needed at parse time and
+     *      the actual renderer used during rendering process.
+     * @param options Options that control the parsing.
+     * @param result Optional. Receives the reason if no document was created.
+     * @return Returns a pointer to a new SVGDocument object. May be nullptr on error.
+     */
+    static std::unique_ptr<SVGDocument> CreateSVGDocumentFromFile(const char* path, std::shared_ptr<SVGNative::SVGRenderer> renderer,
+        const ParseOptions& options = ParseOptions(), ParseResult* result = nullptr);
+
+    /**
+     * Creates a document from the render tree saved by Serialize(). No XML, numbers or
+     * styles get parsed. The data is never modified and needs no alignment. It may be
+     * a memory-mapped file and can be released as soon as this function returns.
+     * @param data Binary document created by Serialize().
+     * @param length Number of bytes in data.
+     * @param renderer The renderer provides the Transform, Shape and Path interface needed at load time and
+     *      the actual renderer used during rendering process.
+     * @param options Options for the document. Only imageCacheSize, isSerializable and computeBounds apply.
+     * @return Returns a pointer to a new SVGDocument object. May be nullptr if data is
+     *      malformed or was written by an incompatible version.
+     */
+    static std::unique_ptr<SVGDocument> CreateFromBinary(const char* data, size_t length, std::shared_ptr<SVGNative::SVGRenderer> renderer,
+        const ParseOptions& options = ParseOptions());
+
     ~SVGDocument();
 
+    /**
+     * Saves the render tree with all styles, resolved gradients, var() placeholders, path
+     * outlines, embedded images and ids in a versioned binary format for CreateFromBinary().
+     * The format is the same on all platforms. Lazy documents get built completely first.
+     * @return Returns the binary document. Empty if the document was not parsed with
+     *      ParseOptions::isSerializable or uses style sheets.
+     */
+    std::vector<char> Serialize();
+
     /**
      * Get the horizontal dimension of the SVG document in local coordinates.
      * @return Horizontal dimension of the SVG document in local coordinates.
@@ -174,9 +360,142 @@ public:
      */
     void Render(const char* id, const ColorMap& colorMap, float width, float height);
 
+    /**
+     * Resolves the names of colorMap to the CSS custom properties the document uses.
+     * Rendering with the result avoids looking up every var() by name. Compile once
+     * and render many times when the colors stay the same.
+     * Lazy documents only know the variables of the elements built so far. Names of
+     * other elements are kept and resolved by name.
+     * @param colorMap A string-to-Color map for pre-defined colors that replace
+     *      CSS custom properties in the SVG file.
+     * @return Compiled color map. Only valid for this document.
+     *
+     * @code
+     * auto compiled = doc->CompileColorMap(colorMap);
+     * for (auto size : sizes)
+     *     doc->Render(compiled, size, size);
+     * @endcode
+     */
+    CompiledColorMap CompileColorMap(const ColorMap& colorMap) const;
+
+    /**
+     * Renders the parsed SVG document to renderer.
+     * See /ref Render(const ColorMap& colorMap) for details.
+     * @param colorMap Color map compiled for this document by CompileColorMap().
+     */
+    void Render(const CompiledColorMap& colorMap);
+
+    /**
+     * Renders the parsed SVG document to renderer.
+     * See /ref Render(const ColorMap& colorMap, float width, float height) for details.
+     * @param colorMap Color map compiled for this document by CompileColorMap().
+     */
+    void Render(const CompiledColorMap& colorMap, float width, float height);
+
+    /**
+     * Renders the subtree of an element with the given XML ID.
+     * See /ref Render(const CompiledColorMap& colorMap) for details.
+     */
+    void Render(const char* id, const CompiledColorMap& colorMap);
+
+    /**
+     * Renders the subtree of an element with the given XML ID.
+     * See /ref Render(const CompiledColorMap& colorMap, float width, float height) for details.
+     */
+    void Render(const char* id, const CompiledColorMap& colorMap, float width, float height);
+
+    /**
+     * Renders the parts of the parsed SVG document that are visible in visibleArea.
+     * Graphics, images and whole groups whose bounds do not intersect visibleArea get
+     * skipped. Rendering a small part of a large document costs accordingly less.
+     * The renderer does not clip to visibleArea, clients restrict drawing to the
+     * visible part of their surface themselves.
+     * Requires ParseOptions::computeBounds. Documents parsed without it render completely.
+     * See /ref Render(const ColorMap& colorMap, float width, float height) for the other parameters.
+     * @param visibleArea Visible part of the surface in the coordinate space of width and height.
+     *
+     * @code
+     * // Zoomed in 4 times, the surface shows the top left corner of the document.
+     * doc->Render(Rect(0, 0, surfaceWidth, surfaceHeight), 4 * surfaceWidth, 4 * surfaceHeight);
+     * @endcode
+     */
+    void Render(const Rect& visibleArea, float width, float height);
+
+    /**
+     * Renders the parts of the parsed SVG document that are visible in visibleArea.
+     * See /ref Render(const Rect& visibleArea, float width, float height) for details.
+     */
+    void Render(const Rect& visibleArea, const ColorMap& colorMap, float width, float height);
+
+    /**
+     * Renders the parts of the parsed SVG document that are visible in visibleArea.
+     * See /ref Render(const Rect& visibleArea, float width, float height) for details.
+     */
+    void Render(const Rect& visibleArea, const CompiledColorMap& colorMap, float width, float height);
+
+    /**
+     * Renders the parsed SVG document to renderer instead of the renderer the document was
+     * created with. renderer must be of the same type. The document does not change, so
+     * several threads may render the same document at once, each to a renderer of its own.
+     * Lazy documents get built completely by the first call. Other threads wait for it.
+     * See /ref Render(const ColorMap& colorMap, float width, float height) for the other parameters.
+     * @param renderer Renderer to draw to.
+     */
+    void RenderTo(SVGNative::SVGRenderer& renderer, const ColorMap& colorMap, float width, float height) const;
+
+    /**
+     * Renders the subtree of an element with the given XML ID to renderer.
+     * See /ref RenderTo(SVGRenderer& renderer, const ColorMap& colorMap, float width, float height) for details.
+     */
+    void RenderTo(SVGNative::SVGRenderer& renderer, const char* id, const ColorMap& colorMap, float width, float height) const;
+
+    /**
+     * Renders the parsed SVG document to renderer with a compiled color map.
+     * See /ref RenderTo(SVGRenderer& renderer, const ColorMap& colorMap, float width, float height) for details.
+     */
+    void RenderTo(SVGNative::SVGRenderer& renderer, const CompiledColorMap& colorMap, float width, float height) const;
+
+    /**
+     * Renders the subtree of an element with the given XML ID to renderer with a compiled color map.
+     * See /ref RenderTo(SVGRenderer& renderer, const ColorMap& colorMap, float width, float height) for details.
+     */
+    void RenderTo(SVGNative::SVGRenderer& renderer, const char* id, const CompiledColorMap& colorMap, float width, float height) const;
+
+    /**
+     * Renders the parts of the parsed SVG document that are visible in visibleArea to renderer.
+     * See /ref Render(const Rect& visibleArea, float width, float height) and
+     * /ref RenderTo(SVGRenderer& renderer, const ColorMap& colorMap, float width, float height) for details.
+     */
+    void RenderTo(
+        SVGNative::SVGRenderer& renderer, const Rect& visibleArea, const CompiledColorMap& colorMap, float width, float height) const;
+
+    /**
+     * Releases all decoded images. They get decoded again on the next rendering.
+     * Useful to reduce memory usage when the document is not going to be rendered for a while.
+     */
+    void PurgeImages();
+
+    /**
+     * Number of shapes that share the Path of an identical shape instead of getting a
+     * Path of their own. Always 0 unless ParseOptions::deduplicatePaths was set.
+     * Lazy documents count the shapes built so far.
+     */
+    size_t DeduplicatedPathCount() const;
+
+    /**
+     * Approximate number of bytes the document keeps in memory. Embedded images count
+     * as decoded, up to ParseOptions::imageCacheSize. Renderer objects are not included.
+     */
+    size_t MemoryEstimate() const;
+
 private:
+    friend class SVGStreamingParser;
+
     SVGDocument();
 
+    // Parses the NUL-terminated text without modifying it. text must outlive this call only.
+    static std::unique_ptr<SVGDocument> CreateSVGDocument(std::unique_ptr<SVGDocumentImpl> document, const char* text);
+
     std::unique_ptr<SVGDocumentImpl> mDocument;
 };
 
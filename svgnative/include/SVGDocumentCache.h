@@ -0,0 +1,91 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#ifndef SVGViewer_SVGDocumentCache_h
+#define SVGViewer_SVGDocumentCache_h
+
+#include "Config.h"
+#include "SVGDocument.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace SVGNative
+{
+class SVGDocumentCacheImpl;
+class SVGRenderer;
+
+/**
+ * Keeps parsed documents for reuse. Documents are found by their SVG content and the
+ * type of the renderer. A 64-bit hash of the content narrows down the candidates and
+ * the content kept with every document decides. All callers that pass the same content get the
+ * same document and render it with SVGDocument::RenderTo() to renderers of their own.
+ * Documents that were not used recently get dropped once all documents together take
+ * more memory than the budget of the cache.
+ *
+ * All methods may be called from several threads at once. A document that is requested
+ * by several threads at the same time gets parsed once.
+ *
+ * @code
+ * static SVGDocumentCache cache(16 * 1024 * 1024);
+ * auto doc = cache.GetDocument(data, length, renderer);
+ * if (doc)
+ *     doc->RenderTo(*renderer, ColorMap(), doc->Width(), doc->Height());
+ * @endcode
+ */
+class SVG_IMP_EXP SVGDocumentCache
+{
+public:
+    /**
+     * Creates an empty cache.
+     * @param budget Upper bound for the memory of all cached documents in bytes, as
+     *      estimated by SVGDocument::MemoryEstimate() plus the size of the SVG content.
+     * @param options Options for parsing documents. Documents are never lazy.
+     */
+    explicit SVGDocumentCache(size_t budget, const ParseOptions& options = ParseOptions());
+    ~SVGDocumentCache();
+
+    /**
+     * Returns the cached document for data and parses it if there is none.
+     * @param data SVG content. Should be UTF8 encoded.
+     * @param length Number of bytes in data.
+     * @param renderer Renderer to parse with if the document is not cached. The document keeps
+     *      it as long as the document exists. Only the type of the renderer is part of the key.
+     * @return Returns the shared document. May be nullptr if data could not be parsed.
+     */
+    std::shared_ptr<const SVGDocument> GetDocument(const char* data, size_t length, std::shared_ptr<SVGRenderer> renderer);
+
+    /**
+     * Drops all documents. Documents still in use elsewhere stay valid.
+     */
+    void Clear();
+
+    /**
+     * Memory of all cached documents in bytes, estimated the same way as the budget.
+     */
+    size_t Size() const;
+
+    /**
+     * Number of cached documents.
+     */
+    size_t Count() const;
+
+private:
+    SVGDocumentCache(const SVGDocumentCache&) = delete;
+    SVGDocumentCache& operator=(const SVGDocumentCache&) = delete;
+
+    std::unique_ptr<SVGDocumentCacheImpl> mCache;
+};
+
+} // namespace SVGNative
+
+#endif // SVGViewer_SVGDocumentCache_h
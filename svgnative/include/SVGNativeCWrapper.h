@@ -68,10 +68,21 @@ SVG_IMP_EXP void svg_native_color_map_destroy(svg_native_color_map_t* color_map)
  * @return The pointer to the newly created SVG Native context. May be NULL on error.
  */
 SVG_IMP_EXP svg_native_t* svg_native_create(svg_native_renderer_type_t renderer_type, const char* document_string);
+/**
+ * Creates a new SVG Native context from the SVG document stored in a file. The file
+ * is mapped into memory and parsed without reading it into an intermediate buffer.
+ * @param render_type The renderer type used for this SVG Native context instance.
+ * @param path The file system path of the SVG document.
+ * @return The pointer to the newly created SVG Native context. NULL if the file could not
+ *      be read or parsed.
+ */
+SVG_IMP_EXP svg_native_t* svg_native_create_from_file(svg_native_renderer_type_t renderer_type, const char* path);
 
 /**
  * Sets a color map to the provided SVG Native context. Only one color map can be used at
  * a time. Calling this function again will replace the currently used color map.
+ * The context resolves the color names once on the next rendering and again only after
+ * colors got added to the color map. The color map must stay alive while it is set.
  * @param sn The SVG Native context.
  * @param color_map A pointer to a color map.
  */
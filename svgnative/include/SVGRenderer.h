@@ -241,6 +241,24 @@ public:
     virtual float Height() const = 0;
 };
 
+/**
+ * Upper bound of the decoded size of base64 data.
+ * @param length Number of base64 characters.
+ * @return Number of bytes the output buffer of Base64Decode() needs.
+ */
+SVG_IMP_EXP size_t Base64DecodedSize(size_t length);
+
+/**
+ * Decodes base64 data into a buffer owned by the caller. Whitespace is skipped.
+ * Uses SIMD instructions where the CPU supports them.
+ * @param base64 Base64 encoded data. Does not need to be NUL terminated.
+ * @param length Number of characters in base64.
+ * @param output Buffer with at least Base64DecodedSize(length) bytes.
+ * @param outputLength Number of decoded bytes.
+ * @return Returns false if base64 has characters that are not part of the encoding.
+ */
+SVG_IMP_EXP bool Base64Decode(const char* base64, size_t length, unsigned char* output, size_t& outputLength);
+
 /**
  * Base class for deriving, platform dependent renderer classes with immediate
  * graphic library calls.
@@ -251,6 +269,16 @@ public:
     virtual ~SVGRenderer() = default;
 
     virtual std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding) = 0;
+
+    /**
+     * Creates an image from base64 data without copying it to a string first. Ports should
+     * override this and decode with Base64Decode() into the buffer the image gets read from.
+     * The default implementation calls the std::string variant.
+     */
+    virtual std::unique_ptr<ImageData> CreateImageData(const char* base64, size_t length, ImageEncoding encoding)
+    {
+        return CreateImageData(std::string(base64, length), encoding);
+    }
     virtual std::unique_ptr<Path> CreatePath() = 0;
     virtual std::unique_ptr<Transform> CreateTransform(
         float a = 1.0, float b = 0.0, float c = 0.0, float d = 1.0, float tx = 0.0, float ty = 0.0) = 0;
@@ -0,0 +1,89 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#ifndef SVGViewer_SVGStreamingParser_h
+#define SVGViewer_SVGStreamingParser_h
+
+#include "Config.h"
+#include "SVGDocument.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace SVGNative
+{
+class SVGDocument;
+class SVGRenderer;
+class SVGStreamingParserImpl;
+
+/**
+ * Push parser that builds the render tree of an SVG document from chunks of data
+ * as they arrive. The complete XML DOM never exists in memory. The children of
+ * <svg>, <g>, <defs> and <symbol> elements get parsed one by one. Any other element,
+ * including its content, gets buffered until its end tag arrives. An <image> with a
+ * large data URL therefore is held in memory as a whole, as are the children of
+ * <defs> that <use> elements may reference.
+ *
+ * @code
+ * SVGStreamingParser parser(renderer);
+ * while (size_t length = ReadChunk(buffer, sizeof(buffer)))
+ * {
+ *     if (!parser.Feed(buffer, length))
+ *         break;
+ * }
+ * auto doc = parser.Finish();
+ * @endcode
+ */
+class SVG_IMP_EXP SVGStreamingParser
+{
+public:
+    /**
+     * Creates a new streaming parser.
+     * @param renderer The renderer provides the Transform, Shape and Path interface needed at parse time and
+     *      the actual renderer used during rendering process.
+     * @param options Options that control the parsing. isLazy and pathThreadCount do not apply.
+     *      ParseLimits::timeLimit applies to every Feed() call on its own, the other limits to
+     *      the whole document.
+     */
+    SVGStreamingParser(std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options = ParseOptions());
+    ~SVGStreamingParser();
+
+    /**
+     * Passes the next chunk of the SVG document to the parser. Elements get added to
+     * the render tree as soon as they are complete. The data gets copied and may be
+     * released after this call.
+     * @param data Next chunk of SVG content. Should be UTF8 encoded.
+     * @param length Number of bytes in data.
+     * @return Returns false if the document is not well-formed or exceeds one of the ParseLimits.
+     *      Further data is ignored then.
+     */
+    bool Feed(const char* data, size_t length);
+
+    /**
+     * Signals the end of the input and hands over the parsed document. The parser
+     * must not be used afterwards.
+     * @param result Optional. Receives the reason if no document was created.
+     * @return Returns a pointer to a new SVGDocument object. May be nullptr if the
+     *      input was incomplete, not well-formed or exceeded one of the ParseLimits.
+     */
+    std::unique_ptr<SVGDocument> Finish(ParseResult* result = nullptr);
+
+private:
+    SVGStreamingParser(const SVGStreamingParser&) = delete;
+    SVGStreamingParser& operator=(const SVGStreamingParser&) = delete;
+
+    std::unique_ptr<SVGStreamingParserImpl> mParser;
+};
+
+} // namespace SVGNative
+
+#endif // SVGViewer_SVGStreamingParser_h
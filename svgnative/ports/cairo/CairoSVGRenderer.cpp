@@ -11,7 +11,6 @@ governing permissions and limitations under the License.
 */
 
 #include "CairoSVGRenderer.h"
-#include "base64.h"
 #include "Config.h"
 #include "cairo.h"
 #include <math.h>
@@ -31,6 +30,7 @@ CairoSVGPath::CairoSVGPath()
 
 CairoSVGPath::~CairoSVGPath()
 {
+    ResetCairoPath();
     cairo_surface_t* sf = cairo_get_target(mPathCtx);
 
     cairo_destroy(mPathCtx);
@@ -38,8 +38,25 @@ CairoSVGPath::~CairoSVGPath()
     cairo_surface_destroy(sf);
 }
 
+const cairo_path_t* CairoSVGPath::CairoPath() const
+{
+    // cairo_copy_path() on the same cairo_t from several threads is not safe.
+    std::lock_guard<std::mutex> lock(mCairoPathMutex);
+    if (!mCairoPath)
+        mCairoPath = cairo_copy_path(mPathCtx);
+    return mCairoPath;
+}
+
+void CairoSVGPath::ResetCairoPath()
+{
+    if (mCairoPath)
+        cairo_path_destroy(mCairoPath);
+    mCairoPath = nullptr;
+}
+
 void CairoSVGPath::Rect(float x, float y, float width, float height)
 {
+    ResetCairoPath();
     cairo_rectangle(mPathCtx, x, y, width, height);
     cairo_close_path(mPathCtx);
 }
@@ -72,6 +89,7 @@ inline void cairo_arc_rx_ry(cairo_t* cr, float cx, float cy, float rx, float ry,
 
 void CairoSVGPath::RoundedRect(float x, float y, float width, float height, float rx, float ry)
 {
+    ResetCairoPath();
     // Cairo does not provide single API to draw "rounded rect". See
     // https://www.cairographics.org/samples/rounded_rectangle/
 
@@ -85,6 +103,7 @@ void CairoSVGPath::RoundedRect(float x, float y, float width, float height, floa
 
 void CairoSVGPath::Ellipse(float cx, float cy, float rx, float ry)
 {
+    ResetCairoPath();
     // Cairo does not provide single API to draw "ellipse". See
     // https://cairographics.org/cookbook/ellipses/
 
@@ -101,6 +120,7 @@ void CairoSVGPath::Ellipse(float cx, float cy, float rx, float ry)
 
 void CairoSVGPath::MoveTo(float x, float y)
 {
+    ResetCairoPath();
     cairo_move_to(mPathCtx, x, y);
     mCurrentX = x;
     mCurrentY = y;
@@ -108,6 +128,7 @@ void CairoSVGPath::MoveTo(float x, float y)
 
 void CairoSVGPath::LineTo(float x, float y)
 {
+    ResetCairoPath();
     cairo_line_to(mPathCtx, x, y);
     mCurrentX = x;
     mCurrentY = y;
@@ -115,6 +136,7 @@ void CairoSVGPath::LineTo(float x, float y)
 
 void CairoSVGPath::CurveTo(float x1, float y1, float x2, float y2, float x3, float y3)
 {
+    ResetCairoPath();
     cairo_curve_to(mPathCtx, x1, y1, x2, y2, x3, y3);
     mCurrentX = x3;
     mCurrentY = y3;
@@ -122,6 +144,7 @@ void CairoSVGPath::CurveTo(float x1, float y1, float x2, float y2, float x3, flo
 
 void CairoSVGPath::CurveToV(float x2, float y2, float x3, float y3)
 {
+    ResetCairoPath();
     cairo_curve_to(mPathCtx, mCurrentX, mCurrentY, x2, y2, x3, y3);
     mCurrentX = x3;
     mCurrentY = y3;
@@ -129,6 +152,7 @@ void CairoSVGPath::CurveToV(float x2, float y2, float x3, float y3)
 
 void CairoSVGPath::ClosePath()
 {
+    ResetCairoPath();
     cairo_close_path(mPathCtx);
 }
 
@@ -165,31 +189,36 @@ void CairoSVGTransform::Concat(const Transform& other)
     cairo_matrix_init(&mMatrix, result.xx, result.yx, result.xy, result.yy, result.x0, result.y0);
 }
 
-CairoSVGImageData::CairoSVGImageData(const std::string& base64, ImageEncoding encoding)
+CairoSVGImageData::CairoSVGImageData(const char* base64, size_t length, ImageEncoding encoding)
 {
-    std::string imageString = base64_decode(base64);
-    const unsigned char* blob_data = (const unsigned char*)malloc(imageString.size());
+    /* decode straight into the blob, cairo keeps it as mime data of the surface */
+    unsigned char* blob_data = (unsigned char*)malloc(Base64DecodedSize(length));
     if (!blob_data)
         throw("no memory\n");
-    memcpy((void *)blob_data, imageString.data(), imageString.size());
+    size_t blob_size{};
+    if (!Base64Decode(base64, length, blob_data, blob_size))
+    {
+        free(blob_data);
+        throw("image is broken, or not PNG or JPEG\n");
+    }
 
     if (encoding == ImageEncoding::kJPEG)
     {
-        mImageData = _cairo_image_surface_create_from_jpeg_stream(blob_data, imageString.size());
+        mImageData = _cairo_image_surface_create_from_jpeg_stream(blob_data, blob_size);
         if (mImageData)
         {
-            cairo_surface_set_mime_data(mImageData, "image/jpeg", blob_data, imageString.size(), free, (void*)blob_data);
+            cairo_surface_set_mime_data(mImageData, "image/jpeg", blob_data, blob_size, free, (void*)blob_data);
             return;
         }
     }
     else if (encoding == ImageEncoding::kPNG)
     {
         /* this closure is used during the construction of the surface, but no need in later */
-        _png_blob_closure_t png_closure{ blob_data, 0, imageString.size() };
+        _png_blob_closure_t png_closure{ blob_data, 0, blob_size };
         mImageData = cairo_image_surface_create_from_png_stream(_png_blob_read_func, &png_closure);
         if (mImageData)
         {
-            cairo_surface_set_mime_data(mImageData, "image/png", blob_data, imageString.size(), free, (void*)blob_data);
+            cairo_surface_set_mime_data(mImageData, "image/png", blob_data, blob_size, free, (void*)blob_data);
             return;
         }
     }
@@ -224,17 +253,15 @@ CairoSVGRenderer::~CairoSVGRenderer()
 {
 }
 
-inline cairo_path_t* getPathObjFromCairoSvgPath( const Path* path )
+inline const cairo_path_t* getPathObjFromCairoSvgPath( const Path* path )
 {
-    cairo_t* cr = static_cast<const CairoSVGPath*>(path)->mPathCtx;
-    return cairo_copy_path(cr);
+    return static_cast<const CairoSVGPath*>(path)->CairoPath();
 }
 
 inline cairo_path_t* getTransformedClippingPath( const ClippingPath* clippingPath )
 {
-    cairo_path_t* path = getPathObjFromCairoSvgPath(clippingPath->path.get());
-    if (!clippingPath->transform)
-        return path;
+    SVG_ASSERT(clippingPath->transform);
+    const cairo_path_t* path = getPathObjFromCairoSvgPath(clippingPath->path.get());
 
     cairo_matrix_t matrix = static_cast<const CairoSVGTransform*>(clippingPath->transform.get())->mMatrix;
     cairo_path_t* pathTransformed = (cairo_path_t*)malloc(sizeof(cairo_path_t));
@@ -253,7 +280,6 @@ inline cairo_path_t* getTransformedClippingPath( const ClippingPath* clippingPat
             pathTransformed->data[i+j].point.y = y;
         }
     }
-    cairo_path_destroy(path);
     return pathTransformed;
 }
 
@@ -283,11 +309,16 @@ void CairoSVGRenderer::Save(const GraphicStyle& graphicStyle)
 
     if (graphicStyle.clippingPath && graphicStyle.clippingPath->path)
     {
-        cairo_path_t* path = getTransformedClippingPath( graphicStyle.clippingPath.get() );
-        cairo_append_path(mCairo, path);
+        if (graphicStyle.clippingPath->transform)
+        {
+            cairo_path_t* path = getTransformedClippingPath( graphicStyle.clippingPath.get() );
+            cairo_append_path(mCairo, path);
+            cairo_path_destroy(path);
+        }
+        else
+            cairo_append_path(mCairo, getPathObjFromCairoSvgPath(graphicStyle.clippingPath->path.get()));
         setCairoFillAndClipRule(mCairo, graphicStyle.clippingPath->clipRule);
         cairo_clip(mCairo);
-        cairo_path_destroy(path);
     }
 }
 
@@ -364,9 +395,7 @@ inline void createCairoPattern(const Paint& paint, float opacity, cairo_pattern_
 
 inline void appendCairoSvgPath(cairo_t* mCairo, const Path& path)
 {
-    cairo_path_t* cairoPath = getPathObjFromCairoSvgPath(&path);
-    cairo_append_path(mCairo, cairoPath);
-    cairo_path_destroy(cairoPath);
+    cairo_append_path(mCairo, getPathObjFromCairoSvgPath(&path));
 }
 
 void CairoSVGRenderer::DrawPath(
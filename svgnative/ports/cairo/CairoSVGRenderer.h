@@ -14,6 +14,7 @@ governing permissions and limitations under the License.
 #define SVGViewer_CairoSVGRenderer_h
 
 #include <list>
+#include <mutex>
 #include "SVGRenderer.h"
 #include "cairo.h"
 
@@ -40,11 +41,20 @@ public:
     void CurveToV(float x2, float y2, float x3, float y3) override;
     void ClosePath() override;
 
+    // Copy of the path to append to the cairo_t of a renderer. It is made on first use
+    // and shared by all threads that render the document.
+    const cairo_path_t* CairoPath() const;
+
     cairo_t* mPathCtx{};
 
 private:
+    void ResetCairoPath();
+
     float mCurrentX{};
     float mCurrentY{};
+
+    mutable std::mutex mCairoPathMutex;
+    mutable cairo_path_t* mCairoPath{};
 };
 
 class CairoSVGTransform final : public Transform
@@ -64,7 +74,7 @@ public:
 class CairoSVGImageData final : public ImageData
 {
 public:
-    CairoSVGImageData(const std::string& base64, ImageEncoding encoding);
+    CairoSVGImageData(const char* base64, size_t length, ImageEncoding encoding);
     ~CairoSVGImageData();
 
     float Width() const override;
@@ -81,7 +91,9 @@ public:
     CairoSVGRenderer();
     ~CairoSVGRenderer();
 
-    std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding encoding) override { return std::unique_ptr<CairoSVGImageData>(new CairoSVGImageData(base64, encoding)); }
+    std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding encoding) override { return CreateImageData(base64.data(), base64.size(), encoding); }
+
+    std::unique_ptr<ImageData> CreateImageData(const char* base64, size_t length, ImageEncoding encoding) override { return std::unique_ptr<CairoSVGImageData>(new CairoSVGImageData(base64, length, encoding)); }
 
     std::unique_ptr<Path> CreatePath() override { return std::unique_ptr<CairoSVGPath>(new CairoSVGPath); }
 
@@ -0,0 +1,150 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "CairoTiledRenderer.h"
+#include "CairoSVGRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace SVGNative
+{
+namespace
+{
+// A1 packs several pixels into a byte, so tiles could not start at any pixel.
+int BytesPerPixel(cairo_format_t format)
+{
+    switch (format)
+    {
+    case CAIRO_FORMAT_ARGB32:
+    case CAIRO_FORMAT_RGB24:
+    case CAIRO_FORMAT_RGB30:
+        return 4;
+    case CAIRO_FORMAT_RGB16_565:
+        return 2;
+    case CAIRO_FORMAT_A8:
+        return 1;
+    default:
+        return 0;
+    }
+}
+} // namespace
+
+bool RenderTiled(const SVGDocument& document, cairo_surface_t* surface, const CompiledColorMap& colorMap, float width,
+    float height, const CairoTileOptions& options)
+{
+    if (!surface || cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS
+        || cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE)
+        return false;
+
+    const auto format = cairo_image_surface_get_format(surface);
+    const auto bytesPerPixel = BytesPerPixel(format);
+    if (!bytesPerPixel)
+        return false;
+
+    // The tiles draw to the pixels of surface directly.
+    cairo_surface_flush(surface);
+    auto data = cairo_image_surface_get_data(surface);
+    const auto surfaceWidth = cairo_image_surface_get_width(surface);
+    const auto surfaceHeight = cairo_image_surface_get_height(surface);
+    const auto stride = cairo_image_surface_get_stride(surface);
+    if (!data)
+        return false;
+
+    // Tiles start at multiples of 16 pixels, which keeps their rows 4-byte aligned as
+    // pixman wants them in every format.
+    const auto tileSize = static_cast<int>((std::min(std::max(options.tileSize, 1u), 1u << 16) + 15) & ~15u);
+    const auto columns = static_cast<size_t>((surfaceWidth + tileSize - 1) / tileSize);
+    const auto rows = static_cast<size_t>((surfaceHeight + tileSize - 1) / tileSize);
+    const auto tileCount = columns * rows;
+    if (!tileCount)
+        return true;
+
+    size_t threadCount = options.threadCount ? options.threadCount : std::thread::hardware_concurrency();
+    threadCount = std::max<size_t>(1, std::min(threadCount, tileCount));
+
+    // Workers grab one tile after the other, so threads that got tiles with little
+    // content go on with the remaining ones.
+    std::atomic<size_t> nextTile{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        CairoSVGRenderer renderer;
+        for (;;)
+        {
+            auto tile = nextTile.fetch_add(1);
+            if (tile >= tileCount)
+                break;
+
+            const auto x = static_cast<int>(tile % columns) * tileSize;
+            const auto y = static_cast<int>(tile / columns) * tileSize;
+            const auto tileWidth = std::min(tileSize, surfaceWidth - x);
+            const auto tileHeight = std::min(tileSize, surfaceHeight - y);
+
+            // Drawing to one surface through several cairo_t at once is not thread-safe.
+            // Each tile gets a surface of its own instead that shares the pixels of surface
+            // and clips to the tile.
+            auto tileSurface = cairo_image_surface_create_for_data(
+                data + y * stride + x * bytesPerPixel, format, tileWidth, tileHeight, stride);
+            auto cairo = cairo_create(tileSurface);
+            cairo_translate(cairo, -x, -y);
+
+            bool succeeded = cairo_status(cairo) == CAIRO_STATUS_SUCCESS;
+            if (succeeded)
+            {
+                renderer.SetCairo(cairo);
+                try
+                {
+                    Rect visibleArea{static_cast<float>(x), static_cast<float>(y), static_cast<float>(tileWidth),
+                        static_cast<float>(tileHeight)};
+                    document.RenderTo(renderer, visibleArea, colorMap, width, height);
+                }
+                catch (...)
+                {
+                    succeeded = false;
+                }
+                succeeded = succeeded && cairo_status(cairo) == CAIRO_STATUS_SUCCESS;
+            }
+
+            cairo_destroy(cairo);
+            cairo_surface_finish(tileSurface);
+            cairo_surface_destroy(tileSurface);
+            if (!succeeded)
+            {
+                failed = true;
+                // Let the other workers stop after their current tile.
+                nextTile = tileCount;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+        threads.reserve(threadCount - 1);
+        for (size_t i = 1; i < threadCount; ++i)
+            threads.emplace_back(worker);
+    }
+    catch (...)
+    {
+        // Continue with the threads that could get started.
+    }
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    cairo_surface_mark_dirty(surface);
+    return !failed;
+}
+
+} // namespace SVGNative
@@ -0,0 +1,69 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#ifndef SVGViewer_CairoTiledRenderer_h
+#define SVGViewer_CairoTiledRenderer_h
+
+#include "Config.h"
+#include "SVGDocument.h"
+#include "cairo.h"
+
+namespace SVGNative
+{
+/**
+ * Options for RenderTiled().
+ */
+struct CairoTileOptions
+{
+    /**
+     * Width and height of the tiles in pixels. Gets rounded up to a multiple of 16.
+     */
+    unsigned int tileSize = 256;
+
+    /**
+     * Number of threads that render tiles. The calling thread counts as one of them.
+     * 0 starts one thread per core.
+     */
+    unsigned int threadCount = 0;
+};
+
+/**
+ * Renders document to an image surface, split into tiles that several threads render at
+ * once. Every thread draws with a CairoSVGRenderer of its own to a cairo_t that is clipped
+ * and translated to its tile. The pixels are the same as if the document was rendered in
+ * one piece. Tiles skip elements outside of them if the document was parsed with
+ * ParseOptions::computeBounds.
+ *
+ * @code
+ * ParseOptions options;
+ * options.computeBounds = true;
+ * auto doc = SVGDocument::CreateSVGDocument(data, renderer, options);
+ * auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 16384, 16384);
+ * RenderTiled(*doc, surface, doc->CompileColorMap(ColorMap()), 16384, 16384);
+ * @endcode
+ *
+ * @param document Document that was created with a CairoSVGRenderer. Lazy documents get
+ *      built completely first.
+ * @param surface Image surface of the format ARGB32, RGB24, RGB30, RGB16_565 or A8.
+ * @param colorMap Colors for CSS variables, see SVGDocument::CompileColorMap().
+ * @param width Width the document gets scaled to, see SVGDocument::Render().
+ * @param height Height the document gets scaled to, see SVGDocument::Render().
+ * @param options Size of the tiles and number of threads.
+ * @return Returns false if surface is not an image surface of a supported format or if
+ *      drawing a tile failed.
+ */
+SVG_IMP_EXP bool RenderTiled(const SVGDocument& document, cairo_surface_t* surface, const CompiledColorMap& colorMap,
+    float width, float height, const CairoTileOptions& options = CairoTileOptions());
+
+} // namespace SVGNative
+
+#endif // SVGViewer_CairoTiledRenderer_h
@@ -11,7 +11,6 @@ governing permissions and limitations under the License.
 */
 
 #include "CGSVGRenderer.h"
-#include "base64.h"
 #include "Config.h"
 
 namespace SVGNative
@@ -77,14 +76,31 @@ void CGSVGTransform::Concat(const Transform& other)
     mTransform = CGAffineTransformConcat(mTransform, static_cast<const CGSVGTransform&>(other).mTransform);
 }
 
-CGSVGImageData::CGSVGImageData(const std::string& base64, ImageEncoding encoding)
+CGSVGImageData::CGSVGImageData(const char* base64, size_t length, ImageEncoding encoding)
 {
-    std::string imageString = base64_decode(base64);
-    auto dataProvider = CGDataProviderCreateWithCFData(CFDataCreate(NULL, (const UInt8*)imageString.data(), imageString.size()));
+    // The CFData takes over the decoded buffer and frees it with the image.
+    auto buffer = static_cast<UInt8*>(malloc(Base64DecodedSize(length)));
+    if (!buffer)
+        return;
+    size_t bufferSize{};
+    if (!Base64Decode(base64, length, buffer, bufferSize))
+    {
+        free(buffer);
+        return;
+    }
+    auto data = CFDataCreateWithBytesNoCopy(NULL, buffer, bufferSize, kCFAllocatorMalloc);
+    if (!data)
+    {
+        free(buffer);
+        return;
+    }
+    auto dataProvider = CGDataProviderCreateWithCFData(data);
     if (encoding == ImageEncoding::kPNG)
         mImage = CGImageCreateWithPNGDataProvider(dataProvider, NULL, true, kCGRenderingIntentDefault);
     else if (encoding == ImageEncoding::kJPEG)
         mImage = CGImageCreateWithJPEGDataProvider(dataProvider, NULL, true, kCGRenderingIntentDefault);
+    CGDataProviderRelease(dataProvider);
+    CFRelease(data);
 }
 
 CGSVGImageData::~CGSVGImageData()
@@ -58,7 +58,7 @@ public:
 class CGSVGImageData final : public ImageData
 {
 public:
-    CGSVGImageData(const std::string& base64, ImageEncoding encoding);
+    CGSVGImageData(const char* base64, size_t length, ImageEncoding encoding);
 
     ~CGSVGImageData();
 
@@ -76,7 +76,9 @@ public:
 
     virtual ~CGSVGRenderer() { ReleaseGraphicsContext(); }
 
-    std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding encoding) override { return std::unique_ptr<CGSVGImageData>(new CGSVGImageData(base64, encoding)); }
+    std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding encoding) override { return CreateImageData(base64.data(), base64.size(), encoding); }
+
+    std::unique_ptr<ImageData> CreateImageData(const char* base64, size_t length, ImageEncoding encoding) override { return std::unique_ptr<CGSVGImageData>(new CGSVGImageData(base64, length, encoding)); }
 
     std::unique_ptr<Path> CreatePath() override { return std::unique_ptr<CGSVGPath>(new CGSVGPath); }
 
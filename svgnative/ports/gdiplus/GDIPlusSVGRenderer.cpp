@@ -15,7 +15,6 @@ governing permissions and limitations under the License.
 
 #include "Config.h"
 #include "GDIPlusSVGRenderer.h"
-#include "base64.h"
 
 namespace SVGNative
 {
@@ -146,25 +145,28 @@ const Gdiplus::Matrix& GDIPlusSVGTransform::GetMatrix() const
     return mTransform;
 }
 
-GDIPlusSVGImageData::GDIPlusSVGImageData(const std::string& base64, ImageEncoding encoding)
+GDIPlusSVGImageData::GDIPlusSVGImageData(const char* base64, size_t length, ImageEncoding encoding)
 {
-    std::string imageString = base64_decode(base64);
-    HGLOBAL hImageData = ::GlobalAlloc(GMEM_MOVEABLE, imageString.size());
+    HGLOBAL hImageData = ::GlobalAlloc(GMEM_MOVEABLE, Base64DecodedSize(length));
     if (hImageData)
     {
         void* imageData = ::GlobalLock(hImageData);
-        if (imageData)
+        size_t imageSize{};
+        if (imageData && Base64Decode(base64, length, static_cast<unsigned char*>(imageData), imageSize))
         {
-            std::memcpy(imageData, imageString.c_str(), imageString.size());
-
             IStream* pImageStream{};
             if (::CreateStreamOnHGlobal(hImageData, FALSE, &pImageStream) == S_OK)
             {
+                // The allocation may be a few bytes larger than the decoded image.
+                ULARGE_INTEGER streamSize{};
+                streamSize.QuadPart = imageSize;
+                pImageStream->SetSize(streamSize);
                 mImage = std::unique_ptr<Gdiplus::Image>(Gdiplus::Image::FromStream(pImageStream, false));
                 pImageStream->Release();
             }
-            ::GlobalUnlock(hImageData);
         }
+        if (imageData)
+            ::GlobalUnlock(hImageData);
         ::GlobalFree(hImageData);
     }
 }
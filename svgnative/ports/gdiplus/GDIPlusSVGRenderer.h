@@ -62,7 +62,7 @@ private:
 class GDIPlusSVGImageData final : public ImageData
 {
 public:
-    GDIPlusSVGImageData(const std::string& base64, ImageEncoding encoding);
+    GDIPlusSVGImageData(const char* base64, size_t length, ImageEncoding encoding);
     ~GDIPlusSVGImageData();
 
     float Width() const override;
@@ -85,7 +85,12 @@ public:
 
     std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding encoding) override 
     { 
-        return std::unique_ptr<GDIPlusSVGImageData>(new GDIPlusSVGImageData(base64, encoding)); 
+        return CreateImageData(base64.data(), base64.size(), encoding); 
+    }
+
+    std::unique_ptr<ImageData> CreateImageData(const char* base64, size_t length, ImageEncoding encoding) override 
+    { 
+        return std::unique_ptr<GDIPlusSVGImageData>(new GDIPlusSVGImageData(base64, length, encoding)); 
     }
 
     std::unique_ptr<Path> CreatePath() override 
@@ -11,7 +11,6 @@ governing permissions and limitations under the License.
 */
 
 #include "SkiaSVGRenderer.h"
-#include "base64.h"
 #include "Config.h"
 #include "SkCanvas.h"
 #include "SkCodec.h"
@@ -134,10 +133,15 @@ inline sk_sp<SkImage> getOrientedImage(sk_sp<SkImage> srcImg, SkEncodedOrigin or
     return skRasterSurface->makeImageSnapshot();
 }
 
-SkiaSVGImageData::SkiaSVGImageData(const std::string& base64, ImageEncoding /*encoding*/)
+SkiaSVGImageData::SkiaSVGImageData(const char* base64, size_t length, ImageEncoding /*encoding*/)
 {
-    std::string imageString = base64_decode(base64);
-    auto skData = SkData::MakeWithCopy(imageString.data(), imageString.size());
+    auto skData = SkData::MakeUninitialized(Base64DecodedSize(length));
+    size_t dataSize{};
+    if (!Base64Decode(base64, length, static_cast<unsigned char*>(skData->writable_data()), dataSize))
+        return;
+    // Shares the buffer, the allocation may be a few bytes larger than the image.
+    if (dataSize < skData->size())
+        skData = SkData::MakeSubset(skData.get(), 0, dataSize);
     SkEncodedOrigin origin = SkCodec::MakeFromData(skData, nullptr)->getOrigin();
     if (origin == SkEncodedOrigin::kTopLeft_SkEncodedOrigin)
         mImageData = SkImage::MakeFromEncoded(skData);
@@ -61,7 +61,7 @@ public:
 class SkiaSVGImageData final : public ImageData
 {
 public:
-    SkiaSVGImageData(const std::string& base64, ImageEncoding encoding);
+    SkiaSVGImageData(const char* base64, size_t length, ImageEncoding encoding);
 
     float Width() const override;
 
@@ -75,7 +75,9 @@ class SVG_IMP_EXP SkiaSVGRenderer final : public SVGRenderer
 public:
     SkiaSVGRenderer();
 
-    std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding encoding) override { return std::unique_ptr<SkiaSVGImageData>(new SkiaSVGImageData(base64, encoding)); }
+    std::unique_ptr<ImageData> CreateImageData(const std::string& base64, ImageEncoding encoding) override { return CreateImageData(base64.data(), base64.size(), encoding); }
+
+    std::unique_ptr<ImageData> CreateImageData(const char* base64, size_t length, ImageEncoding encoding) override { return std::unique_ptr<SkiaSVGImageData>(new SkiaSVGImageData(base64, length, encoding)); }
 
     std::unique_ptr<Path> CreatePath() override { return std::unique_ptr<SkiaSVGPath>(new SkiaSVGPath); }
 
@@ -159,6 +159,17 @@ def readLine(p):
         c = p.stdout.read(1)
     return line
 
+def testArguments(fbase):
+    # Elements with the id "ref" get rendered on their own, limits-* files get parsed with limits,
+    # cull-* files get rendered with a visible area.
+    if fbase.startswith('elem-'):
+        return ['ref']
+    if fbase.startswith('limits-'):
+        return ['--limits']
+    if fbase.startswith('cull-'):
+        return ['--cull']
+    return []
+
 def exportTestFilesSequential(files, args):
     hasError = 0
     while True:
@@ -175,23 +186,17 @@ def exportTestFilesSequential(files, args):
         # TODO: preserve sub-dirs
         actualFile = os.path.abspath(os.path.join(args.result_dir, fbase + '.txt'))
         diffFile = os.path.abspath(os.path.join(args.result_dir, fbase + '-diff.txt'))
-        elementRef = fbase.startswith('elem-')
+        testArgs = testArguments(fbase)
         if not os.path.exists(expectedFile):
             isExpectedFileMissing = True
-            if not elementRef:
-                p = Popen([args.program, inputFile, expectedFile])
-            else:
-                p = Popen([args.program, inputFile, expectedFile, 'ref'])                
+            p = Popen([args.program, inputFile, expectedFile] + testArgs)
             if p == None:
                 print('Error opening testapp')
                 hasError = -1
                 continue
             print('Created missing expectation file: ' + expectedFile)
         else:
-            if not elementRef:
-                p = Popen([args.program, inputFile, actualFile])
-            else:
-                p = Popen([args.program, inputFile, actualFile, 'ref'])    
+            p = Popen([args.program, inputFile, actualFile] + testArgs)
             if p == None:
                 print('Error opening testapp')
                 hasError = -1
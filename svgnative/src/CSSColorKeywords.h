@@ -13,13 +13,18 @@ governing permissions and limitations under the License.
 #pragma once
 
 #include "SVGRenderer.h"
-#include <array>
-#include <tuple>
+#include <cstddef>
+#include <cstdint>
 
 namespace SVGNative
 {
 
-using CSSColorInfo = std::tuple<const char*, size_t, Color>;
+struct CSSColorInfo
+{
+    const char* name;
+    std::size_t length;
+    Color color;
+};
 
 // Generated in web browser with following code. ele must be an element embedded in a loaded document.
 // var string = '';
@@ -30,7 +35,7 @@ using CSSColorInfo = std::tuple<const char*, size_t, Color>;
 //         + rgb.map(item => { return String(rgb[0] + '.0f / 255.0f').padStart(13)}).join(', ')
 //         + ', 1.0f}}},\n';
 // });
-constexpr std::array<CSSColorInfo, 148> gCSSNamedColors = {{
+constexpr CSSColorInfo gCSSNamedColors[148] = {
     CSSColorInfo{"aliceblue"            , 9  , {{240.0f / 255.0f, 248.0f / 255.0f, 255.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"antiquewhite"         , 12 , {{250.0f / 255.0f, 235.0f / 255.0f, 215.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"aqua"                 , 4  , {{  0.0f / 255.0f, 255.0f / 255.0f, 255.0f / 255.0f, 1.0f}}},
@@ -98,7 +103,7 @@ constexpr std::array<CSSColorInfo, 148> gCSSNamedColors = {{
     CSSColorInfo{"lavenderblush"        , 13 , {{255.0f / 255.0f, 240.0f / 255.0f, 245.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"lawngreen"            , 9  , {{124.0f / 255.0f, 252.0f / 255.0f,   0.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"lemonchiffon"         , 12 , {{255.0f / 255.0f, 250.0f / 255.0f, 205.0f / 255.0f, 1.0f}}},
-    CSSColorInfo{"darkslateblue"        , 13 , {{ 72.0f / 255.0f,  61.0f / 255.0f, 139.0f / 255.0f, 1.0f}}},
+    CSSColorInfo{"lightblue"            , 9  , {{173.0f / 255.0f, 216.0f / 255.0f, 230.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"lightcoral"           , 10 , {{240.0f / 255.0f, 128.0f / 255.0f, 128.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"lightcyan"            , 9  , {{224.0f / 255.0f, 255.0f / 255.0f, 255.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"lightgoldenrodyellow" , 20 , {{250.0f / 255.0f, 250.0f / 255.0f, 210.0f / 255.0f, 1.0f}}},
@@ -179,6 +184,86 @@ constexpr std::array<CSSColorInfo, 148> gCSSNamedColors = {{
     CSSColorInfo{"whitesmoke"           , 10 , {{245.0f / 255.0f, 245.0f / 255.0f, 245.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"yellow"               , 6  , {{255.0f / 255.0f, 255.0f / 255.0f,   0.0f / 255.0f, 1.0f}}},
     CSSColorInfo{"yellowgreen"          , 11 , {{154.0f / 255.0f, 205.0f / 255.0f,  50.0f / 255.0f, 1.0f}}}
-}};
+};
+
+// Perfect hash over gCSSNamedColors. The 32-bit FNV-1a hash of the lowercase
+// name selects a bucket in gCSSNamedColorSeeds. Hashing the name again with the
+// seed of its bucket as offset basis selects the slot in gCSSNamedColorSlots that
+// holds the index into gCSSNamedColors. Empty slots hold 0xFF. The seeds were
+// found by assigning the largest buckets first and trying seeds from 1 upwards
+// until all names of a bucket land on free slots.
+constexpr std::uint32_t kCSSNamedColorBasis = 2166136261u;
+
+constexpr std::uint8_t gCSSNamedColorSeeds[64] = {
+      0,   0,   0,   2,   1,   1,   1,   0,   2,   5,   2,   0,   3,   2,   4,   1,
+      1,   3,   1,   2,   1,   5,   1,   1,   1,   3,   1,   0,  13,   3,  10,   1,
+      3,   0,   1,   0,   4,   0,   2,   4,   3,   1,   2,   4,   2,   5,   4,   1,
+      6,   5,   3,   3,   4,   1,   2,   2,   0,   1,   2,   2,   1,   2,   9,   1
+};
+
+constexpr std::uint8_t gCSSNamedColorSlots[256] = {
+    117,  41,   0, 121, 255, 255, 255, 255, 134, 125,  72,  13,  34,  62, 255, 108,
+    255, 255, 255,  48,  57, 132, 255, 255,  92,  20,  28, 135, 255, 255, 255, 255,
+     54, 255, 255,  33,  32,  27,  16, 255,  99,  26, 255, 255, 137, 255, 128, 144,
+    255,  79,  65, 118, 120, 255, 123,   7,  55, 255,  78, 110, 255,  22, 106,  35,
+    255, 255, 255, 255, 255, 255, 255, 255,  84,  23,  68,  42, 255, 255, 255, 255,
+     82,  86,  74, 113, 255,  10,  49, 133, 255,  90, 255,  70, 143, 255, 255, 255,
+    255,  73,   4, 255,  66,  31, 255, 255,  69, 255, 255,  14, 255, 255,  93,  77,
+    255,  97,  80, 138,  83, 255, 141, 255, 142, 136,  85, 145, 255,  56, 103, 255,
+     71, 122,  44,   1,  87, 255, 255,  61,  25, 146,  47, 255, 140, 255,  38, 255,
+     51, 255,   9,  63, 104,  36, 116, 255,  39, 255,  50,  96, 114, 255,  53,  17,
+     81,  75, 255, 255, 255,   5,  12, 255, 126,  18, 255,  46, 102, 115, 255, 255,
+     94,  76, 255, 100, 255, 147, 255, 255, 139, 107, 255, 124, 255, 112,  67, 101,
+    255, 255, 255, 255,  58, 255, 255, 255, 255,  52,  64, 255,  40, 127,  43,  88,
+     91, 255, 129, 255, 255,   2, 255, 111, 255, 255,  60,  11, 255, 255, 119, 255,
+     29,  19, 255,   3, 255, 255,  21, 255, 255,  95, 255, 131, 255,  89, 255, 255,
+     59,   8,  30, 255,  98, 255,  24,  37, 255, 130, 109,  15, 255,   6, 105,  45
+};
+
+constexpr unsigned char ToLowerASCII(char c)
+{
+    return static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+}
+
+constexpr std::uint32_t CSSNamedColorHash(const char* name, std::size_t length, std::uint32_t basis)
+{
+    return length == 0 ? basis : CSSNamedColorHash(name + 1, length - 1, (basis ^ ToLowerASCII(*name)) * 16777619u);
+}
+
+constexpr std::size_t CSSNamedColorSlot(const char* name, std::size_t length)
+{
+    return CSSNamedColorHash(name, length, gCSSNamedColorSeeds[CSSNamedColorHash(name, length, kCSSNamedColorBasis) % 64]) % 256;
+}
+
+constexpr std::size_t CSSNameLength(const char* name) { return *name ? 1 + CSSNameLength(name + 1) : 0; }
+
+constexpr bool IsPerfectCSSNamedColorTable(std::size_t index = 0)
+{
+    return index == 148
+        || (gCSSNamedColors[index].length == CSSNameLength(gCSSNamedColors[index].name)
+            && gCSSNamedColorSlots[CSSNamedColorSlot(gCSSNamedColors[index].name, gCSSNamedColors[index].length)] == index
+            && IsPerfectCSSNamedColorTable(index + 1));
+}
+
+static_assert(IsPerfectCSSNamedColorTable(), "Every color name must be stored at the slot of its hash.");
+
+// Returns the named color that matches the given name case-insensitively or
+// nullptr. The name does not need to be NUL-terminated.
+inline const CSSColorInfo* FindCSSNamedColor(const char* name, size_t length)
+{
+    auto index = gCSSNamedColorSlots[CSSNamedColorSlot(name, length)];
+    if (index == 0xFF)
+        return nullptr;
+
+    const auto& namedColor = gCSSNamedColors[index];
+    if (namedColor.length != length)
+        return nullptr;
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (ToLowerASCII(name[i]) != static_cast<unsigned char>(namedColor.name[i]))
+            return nullptr;
+    }
+    return &namedColor;
+}
 
 }
\ No newline at end of file
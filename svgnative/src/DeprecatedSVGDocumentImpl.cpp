@@ -32,7 +32,7 @@ void SVGDocumentImpl::ParseStyle(XMLNode* child)
 
     // StyleSheet Library expects one definition per line, so we need to
     // format the string accordingly.
-    std::string styleSheet = std::string(child->value());
+    std::string styleSheet = std::string(child->value(), child->value_size());
 
     SVG_CSS_TRACE("ParseStyle INPUT:\n" << styleSheet);
 
@@ -84,6 +84,11 @@ void SVGDocumentImpl::ParseStyle(XMLNode* child)
     mCSSInfo = StyleSheet::CssDocument::parse(output);
 }
 
+bool SVGDocumentImpl::HasOverrideStyle(const Node& node) const
+{
+    return mOverrideStyle && !mClassNames[node.classNames].empty();
+}
+
 void SVGDocumentImpl::ApplyCSSStyle(
     const std::set<std::string>& classNames, GraphicStyleImpl& graphicStyle, FillStyleImpl& fillStyle, StrokeStyleImpl& strokeStyle)
 {
@@ -97,7 +102,8 @@ void SVGDocumentImpl::ApplyCSSStyle(
             continue;
 
         auto cssElement = mOverrideStyle->getElement(selector);
-        auto properties = cssElement.getProperties();
+        auto propertySet = cssElement.getProperties();
+        auto properties = ClassifyProperties(propertySet);
         ParseGraphicsProperties(graphicStyle, properties);
         ParseFillProperties(fillStyle, properties);
         ParseStrokeProperties(strokeStyle, properties);
@@ -109,7 +115,7 @@ void SVGDocumentImpl::ParseStyleAttr(XMLNode* node, std::vector<PropertySet>& pr
     auto attr = node->first_attribute("style");
     if (attr)
     {
-        auto cssDoc = StyleSheet::CssDocument::parse(attr->value());
+        auto cssDoc = StyleSheet::CssDocument::parse(std::string(attr->value(), attr->value_size()));
         auto cssElements = cssDoc.getElements();
         if (!cssElements.empty())
         {
@@ -123,7 +129,7 @@ void SVGDocumentImpl::ParseStyleAttr(XMLNode* node, std::vector<PropertySet>& pr
     if (attr)
     {
         boost::char_separator<char> sep("\n\r\t ");
-        std::string cssString = attr->value();
+        std::string cssString{attr->value(), attr->value_size()};
         boost::tokenizer<boost::char_separator<char>> tok(cssString, sep);
         for (boost::tokenizer<boost::char_separator<char>>::iterator it = tok.begin(); it != tok.end(); ++it)
         {
@@ -12,6 +12,7 @@ governing permissions and limitations under the License.
 
 #include "SVGDocument.h"
 #include "SVGDocumentImpl.h"
+#include "SVGParseBudget.h"
 #include "SVGRenderer.h"
 #ifdef STYLE_SUPPORT
 #include "StyleSheet/Document.h"
@@ -20,26 +21,233 @@ governing permissions and limitations under the License.
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/property_tree/detail/xml_parser_read_rapidxml.hpp>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <stdlib.h>
 #include <string>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace boost::property_tree::detail::rapidxml;
 
 namespace SVGNative
 {
+namespace
+{
+// Read-only view of a file in memory. On POSIX systems the rest of the last page after
+// the content is zero filled. If the content does not end on a page boundary, the
+// mapping is followed by a NUL byte then and can be parsed without a copy.
+class MappedFile
+{
+public:
+    explicit MappedFile(const char* path)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER size{};
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && static_cast<unsigned long long>(size.QuadPart) <= SIZE_MAX)
+        {
+            if (HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+            {
+                if (auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+                {
+                    mData = static_cast<char*>(view);
+                    mSize = static_cast<size_t>(size.QuadPart);
+                }
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info{};
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            auto size = static_cast<size_t>(info.st_size);
+            auto pageSize = sysconf(_SC_PAGESIZE);
+            bool hasSlack = pageSize > 0 && size % static_cast<size_t>(pageSize) != 0;
+            auto addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                mData = static_cast<char*>(addr);
+                mSize = size;
+                mIsTerminated = hasSlack;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+        if (!mData)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+#else
+        munmap(mData, mSize);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* Data() const { return mData; }
+    size_t Size() const { return mSize; }
+    // True if the mapping is followed by a NUL byte.
+    bool IsTerminated() const { return mIsTerminated; }
+
+private:
+    char* mData{};
+    size_t mSize{};
+    bool mIsTerminated{};
+};
+} // namespace
+
+std::unique_ptr<SVGDocument> SVGDocument::CreateSVGDocument(std::unique_ptr<SVGDocumentImpl> document, const char* text)
+{
+    document->ParseXML(text);
+    document->TraverseSVGTree();
+    if (!document->IsLazy())
+        document->mXMLDocument.clear();
+
+    auto retval = new SVGDocument();
+    retval->mDocument = std::move(document);
+
+    return std::unique_ptr<SVGDocument>(retval);
+}
+
 std::unique_ptr<SVGDocument> SVGDocument::CreateSVGDocument(const char* s, std::shared_ptr<SVGRenderer> renderer)
 {
     try
     {
         auto realSVGDoc = std::unique_ptr<SVGDocumentImpl>(new SVGDocumentImpl(renderer));
-        realSVGDoc->mXMLDocument.parse<0>((char*)s); // 0 means default parse flags
-        realSVGDoc->TraverseSVGTree();
-        realSVGDoc->mXMLDocument.clear();
+        return CreateSVGDocument(std::move(realSVGDoc), s);
+    }
+    catch (...)
+    {
+    }
+
+    return nullptr;
+}
+
+std::unique_ptr<SVGDocument> SVGDocument::CreateSVGDocument(
+    const char* data, size_t length, std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options, ParseResult* result)
+{
+    auto failure = ParseResult::kInvalidDocument;
+    if (!data)
+    {
+        if (result)
+            *result = failure;
+        return nullptr;
+    }
+
+    try
+    {
+        auto realSVGDoc = std::unique_ptr<SVGDocumentImpl>(new SVGDocumentImpl(renderer, options));
+        // Parse the buffer directly if it is terminated already. Lazy documents keep referring
+        // to the content after this call and always need the copy.
+        const char* text = data;
+        if (!length || data[length - 1] != '\0' || options.isLazy)
+        {
+            // RapidXML relies on a terminating NUL and may not read past length. Parse a
+            // terminated copy that lives in the memory pool of the XML document. The pool
+            // is released together with the DOM right after traversal, or once a lazy
+            // document is built completely.
+            auto buffer = realSVGDoc->mXMLDocument.allocate_string(nullptr, length + 1);
+            memcpy(buffer, data, length);
+            buffer[length] = '\0';
+            text = buffer;
+        }
+        auto document = CreateSVGDocument(std::move(realSVGDoc), text);
+        if (result)
+            *result = ParseResult::kSuccess;
+        return document;
+    }
+    catch (const ParseLimitError& error)
+    {
+        failure = error.Result();
+    }
+    catch (...)
+    {
+    }
+
+    if (result)
+        *result = failure;
+    return nullptr;
+}
+
+std::unique_ptr<SVGDocument> SVGDocument::CreateSVGDocumentFromFile(
+    const char* path, std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options, ParseResult* result)
+{
+    auto failure = ParseResult::kInvalidDocument;
+    if (!path)
+    {
+        if (result)
+            *result = failure;
+        return nullptr;
+    }
+
+    MappedFile file(path);
+    if (!file.Data())
+    {
+        if (result)
+            *result = failure;
+        return nullptr;
+    }
+
+    // Parse straight from the mapping if it is terminated. Otherwise copy the content
+    // once into the memory pool of the XML document. Lazy documents keep referring to
+    // the content after the file got unmapped and always need the copy.
+    if (!file.IsTerminated() || options.isLazy)
+        return CreateSVGDocument(file.Data(), file.Size(), renderer, options, result);
+
+    try
+    {
+        auto realSVGDoc = std::unique_ptr<SVGDocumentImpl>(new SVGDocumentImpl(renderer, options));
+        auto document = CreateSVGDocument(std::move(realSVGDoc), file.Data());
+        if (result)
+            *result = ParseResult::kSuccess;
+        return document;
+    }
+    catch (const ParseLimitError& error)
+    {
+        failure = error.Result();
+    }
+    catch (...)
+    {
+    }
+
+    if (result)
+        *result = failure;
+    return nullptr;
+}
+
+std::unique_ptr<SVGDocument> SVGDocument::CreateFromBinary(
+    const char* data, size_t length, std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options)
+{
+    if (!data)
+        return nullptr;
+
+    try
+    {
+        auto realSVGDoc = std::unique_ptr<SVGDocumentImpl>(new SVGDocumentImpl(renderer, options));
+        realSVGDoc->Deserialize(data, length);
 
         auto retval = new SVGDocument();
         retval->mDocument = std::move(realSVGDoc);
-
         return std::unique_ptr<SVGDocument>(retval);
     }
     catch (...)
@@ -59,7 +267,7 @@ void SVGDocument::Render()
         return;
 
     ColorMap colorMap;
-    mDocument->Render(colorMap, mDocument->mViewBox[2], mDocument->mViewBox[3]);
+    mDocument->Render(nullptr, colorMap, mDocument->mViewBox[2], mDocument->mViewBox[3]);
 }
 
 void SVGDocument::Render(float width, float height)
@@ -68,7 +276,7 @@ void SVGDocument::Render(float width, float height)
         return;
 
     ColorMap colorMap;
-    mDocument->Render(colorMap, width, height);
+    mDocument->Render(nullptr, colorMap, width, height);
 }
 
 void SVGDocument::Render(const ColorMap& colorMap)
@@ -76,14 +284,14 @@ void SVGDocument::Render(const ColorMap& colorMap)
     if (!mDocument)
         return;
 
-    mDocument->Render(colorMap, mDocument->mViewBox[2], mDocument->mViewBox[3]);
+    mDocument->Render(nullptr, colorMap, mDocument->mViewBox[2], mDocument->mViewBox[3]);
 }
 
 void SVGDocument::Render(const ColorMap& colorMap, float width, float height) {
     if (!mDocument)
         return;
 
-    mDocument->Render(colorMap, width, height);
+    mDocument->Render(nullptr, colorMap, width, height);
 }
 
 void SVGDocument::Render(const char* id)
@@ -120,6 +328,154 @@ void SVGDocument::Render(const char* id, const ColorMap& colorMap, float width,
     mDocument->Render(id, colorMap, width, height);
 }
 
+void SVGDocument::Render(const Rect& visibleArea, float width, float height)
+{
+    if (!mDocument)
+        return;
+
+    ColorMap colorMap;
+    mDocument->Render(nullptr, colorMap, width, height, &visibleArea);
+}
+
+void SVGDocument::Render(const Rect& visibleArea, const ColorMap& colorMap, float width, float height)
+{
+    if (!mDocument)
+        return;
+
+    mDocument->Render(nullptr, colorMap, width, height, &visibleArea);
+}
+
+void SVGDocument::Render(const Rect& visibleArea, const CompiledColorMap& colorMap, float width, float height)
+{
+    if (!mDocument)
+        return;
+
+    mDocument->Render(nullptr, colorMap, width, height, &visibleArea);
+}
+
+void SVGDocument::RenderTo(SVGRenderer& renderer, const ColorMap& colorMap, float width, float height) const
+{
+    if (!mDocument)
+        return;
+
+    mDocument->RenderTo(renderer, nullptr, colorMap, width, height);
+}
+
+void SVGDocument::RenderTo(SVGRenderer& renderer, const char* id, const ColorMap& colorMap, float width, float height) const
+{
+    if (!mDocument || !id)
+        return;
+
+    mDocument->RenderTo(renderer, id, colorMap, width, height);
+}
+
+CompiledColorMap SVGDocument::CompileColorMap(const ColorMap& colorMap) const
+{
+    CompiledColorMap compiledColorMap;
+    if (mDocument)
+        mDocument->CompileColorMap(colorMap, compiledColorMap);
+    return compiledColorMap;
+}
+
+void SVGDocument::Render(const CompiledColorMap& colorMap)
+{
+    if (!mDocument)
+        return;
+
+    mDocument->Render(nullptr, colorMap, mDocument->mViewBox[2], mDocument->mViewBox[3]);
+}
+
+void SVGDocument::Render(const CompiledColorMap& colorMap, float width, float height)
+{
+    if (!mDocument)
+        return;
+
+    mDocument->Render(nullptr, colorMap, width, height);
+}
+
+void SVGDocument::Render(const char* id, const CompiledColorMap& colorMap)
+{
+    if (!mDocument || !id)
+        return;
+
+    mDocument->Render(id, colorMap, mDocument->mViewBox[2], mDocument->mViewBox[3]);
+}
+
+void SVGDocument::Render(const char* id, const CompiledColorMap& colorMap, float width, float height)
+{
+    if (!mDocument || !id)
+        return;
+
+    mDocument->Render(id, colorMap, width, height);
+}
+
+void SVGDocument::RenderTo(SVGRenderer& renderer, const CompiledColorMap& colorMap, float width, float height) const
+{
+    if (!mDocument)
+        return;
+
+    mDocument->RenderTo(renderer, nullptr, colorMap, width, height);
+}
+
+void SVGDocument::RenderTo(SVGRenderer& renderer, const char* id, const CompiledColorMap& colorMap, float width, float height) const
+{
+    if (!mDocument || !id)
+        return;
+
+    mDocument->RenderTo(renderer, id, colorMap, width, height);
+}
+
+void SVGDocument::RenderTo(
+    SVGRenderer& renderer, const Rect& visibleArea, const CompiledColorMap& colorMap, float width, float height) const
+{
+    if (!mDocument)
+        return;
+
+    mDocument->RenderTo(renderer, nullptr, colorMap, width, height, &visibleArea);
+}
+
+void SVGDocument::PurgeImages()
+{
+    if (!mDocument)
+        return;
+
+    mDocument->PurgeImages(0);
+}
+
+std::vector<char> SVGDocument::Serialize()
+{
+    std::vector<char> data;
+    if (!mDocument)
+        return data;
+
+    try
+    {
+        if (!mDocument->Serialize(data))
+            data.clear();
+    }
+    catch (...)
+    {
+        data.clear();
+    }
+    return data;
+}
+
+size_t SVGDocument::DeduplicatedPathCount() const
+{
+    if (!mDocument)
+        return 0;
+
+    return mDocument->DeduplicatedPathCount();
+}
+
+size_t SVGDocument::MemoryEstimate() const
+{
+    if (!mDocument)
+        return 0;
+
+    return mDocument->EstimateMemory();
+}
+
 std::int32_t SVGDocument::Width() const
 {
     if (!mDocument)
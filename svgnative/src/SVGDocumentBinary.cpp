@@ -0,0 +1,864 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "SVGDocumentImpl.h"
+#include "SVGPathRecorder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Binary form of the render tree. All numbers are little endian, floats are IEEE 754
+// single precision, counts and indices take 32 bits. Nothing is aligned, the data may
+// be read from any address, e.g. a memory-mapped file. The sections follow each other
+// in this order:
+//
+//   header            "SVNB", version, viewBox
+//   transforms        {a, b, c, d, tx, ty}
+//   paths             command count, value count, commands, values
+//   image sources     encoding, decoded size, base64 data
+//   clipping paths    flags, path, transform
+//   gradients         geometry, transform, color stops
+//   graphic styles, fill styles, stroke styles, class names
+//   images            image source, clip area, fill area
+//   shape paths       path for each index a graphic node refers to
+//   render trees      nodes in pre-order
+//   ids               id, tree, node
+//
+// Later sections refer to objects of earlier sections by index. Objects shared in
+// the document, e.g. gradients referenced by several paints, are stored once.
+
+namespace SVGNative
+{
+namespace
+{
+const char kMagic[4] = {'S', 'V', 'N', 'B'};
+// Increase on every change of the layout.
+constexpr std::uint32_t kVersion = 1;
+// Index of a missing optional object.
+constexpr std::uint32_t kNone = 0xFFFFFFFF;
+
+enum class ColorTag : std::uint8_t
+{
+    kColor,
+    kVariable,
+    kColorKey
+};
+
+enum class PaintTag : std::uint8_t
+{
+    kColor,
+    kGradient,
+    kVariable,
+    kColorKey
+};
+
+enum class PathCommand : std::uint8_t
+{
+    kRect,
+    kRoundedRect,
+    kEllipse,
+    kMoveTo,
+    kLineTo,
+    kCurveTo,
+    kCurveToV,
+    kClosePath
+};
+
+// Number of values each PathCommand takes.
+const std::uint8_t gPathCommandValueCounts[] = {4, 6, 4, 2, 2, 6, 4, 0};
+
+[[noreturn]] void ThrowInvalid() { throw std::runtime_error("Invalid binary document"); }
+
+class BinaryWriter
+{
+public:
+    void U8(std::uint8_t value) { mData.push_back(static_cast<char>(value)); }
+    void Bool(bool value) { U8(value ? 1 : 0); }
+
+    void U32(std::uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8)
+            U8(static_cast<std::uint8_t>(value >> shift));
+    }
+
+    void U64(std::uint64_t value)
+    {
+        for (int shift = 0; shift < 64; shift += 8)
+            U8(static_cast<std::uint8_t>(value >> shift));
+    }
+
+    void Float(float value)
+    {
+        std::uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        U32(bits);
+    }
+
+    void Count(size_t count)
+    {
+        if (count >= kNone)
+            throw std::length_error("Too many objects for the binary format");
+        U32(static_cast<std::uint32_t>(count));
+    }
+
+    void String(const std::string& value)
+    {
+        Count(value.size());
+        mData.insert(mData.end(), value.begin(), value.end());
+    }
+
+    void Color(const SVGNative::Color& color)
+    {
+        for (auto component : color)
+            Float(component);
+    }
+
+    void Rect(const SVGNative::Rect& rect)
+    {
+        Float(rect.x);
+        Float(rect.y);
+        Float(rect.width);
+        Float(rect.height);
+    }
+
+    void ColorImpl(const SVGNative::ColorImpl& color)
+    {
+        if (color.type() == typeid(Variable))
+        {
+            const auto& var = boost::get<Variable>(color);
+            U8(static_cast<std::uint8_t>(ColorTag::kVariable));
+            String(var.name);
+            Color(var.fallback);
+        }
+        else if (color.type() == typeid(ColorKeys))
+        {
+            U8(static_cast<std::uint8_t>(ColorTag::kColorKey));
+            U8(static_cast<std::uint8_t>(boost::get<ColorKeys>(color)));
+        }
+        else
+        {
+            U8(static_cast<std::uint8_t>(ColorTag::kColor));
+            Color(boost::get<SVGNative::Color>(color));
+        }
+    }
+
+    const std::vector<char>& Data() const { return mData; }
+
+private:
+    std::vector<char> mData;
+};
+
+// Reads the data written by BinaryWriter. Throws if the data ends early or a value
+// is out of range.
+class BinaryReader
+{
+public:
+    BinaryReader(const char* data, size_t length)
+        : mPos{reinterpret_cast<const unsigned char*>(data)}
+        , mEnd{mPos + length}
+    {
+    }
+
+    const unsigned char* Bytes(size_t length)
+    {
+        if (static_cast<size_t>(mEnd - mPos) < length)
+            ThrowInvalid();
+        auto bytes = mPos;
+        mPos += length;
+        return bytes;
+    }
+
+    std::uint8_t U8() { return *Bytes(1); }
+
+    bool Bool()
+    {
+        auto value = U8();
+        if (value > 1)
+            ThrowInvalid();
+        return value != 0;
+    }
+
+    std::uint32_t U32()
+    {
+        auto bytes = Bytes(4);
+        return static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8)
+            | (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+    }
+
+    std::uint64_t U64()
+    {
+        std::uint64_t low = U32();
+        return low | (static_cast<std::uint64_t>(U32()) << 32);
+    }
+
+    float Float()
+    {
+        auto bits = U32();
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Reads the number of the following objects. Each object takes at least elementSize
+    // bytes, larger counts than the remaining data allows are rejected before anything
+    // gets allocated for them.
+    std::uint32_t Count(size_t elementSize)
+    {
+        auto count = U32();
+        if (elementSize && count > static_cast<size_t>(mEnd - mPos) / elementSize)
+            ThrowInvalid();
+        return count;
+    }
+
+    // Reads an index into a table with size objects. kNone is accepted if isOptional is set.
+    std::uint32_t Index(size_t size, bool isOptional = false)
+    {
+        auto index = U32();
+        if (index >= size && !(isOptional && index == kNone))
+            ThrowInvalid();
+        return index;
+    }
+
+    template <typename E>
+    E Enum(E last)
+    {
+        auto value = U8();
+        if (value > static_cast<std::uint8_t>(last))
+            ThrowInvalid();
+        return static_cast<E>(value);
+    }
+
+    std::string String()
+    {
+        auto length = Count(1);
+        return std::string(reinterpret_cast<const char*>(Bytes(length)), length);
+    }
+
+    SVGNative::Color Color()
+    {
+        SVGNative::Color color;
+        for (auto& component : color)
+            component = Float();
+        return color;
+    }
+
+    SVGNative::Rect Rect()
+    {
+        SVGNative::Rect rect;
+        rect.x = Float();
+        rect.y = Float();
+        rect.width = Float();
+        rect.height = Float();
+        return rect;
+    }
+
+    SVGNative::ColorImpl ColorImpl()
+    {
+        switch (Enum(ColorTag::kColorKey))
+        {
+        case ColorTag::kVariable:
+        {
+            auto name = String();
+            return Variable{std::move(name), Color()};
+        }
+        case ColorTag::kColorKey:
+            return Enum(ColorKeys::kCurrentColor);
+        default:
+            return Color();
+        }
+    }
+
+    bool AtEnd() const { return mPos == mEnd; }
+
+private:
+    const unsigned char* mPos;
+    const unsigned char* mEnd;
+};
+
+// Numbers shared objects in the order they are first referenced.
+template <typename T>
+class ObjectTable
+{
+public:
+    std::uint32_t Add(const T* object)
+    {
+        if (!object)
+            return kNone;
+        auto result = mIndices.emplace(object, static_cast<std::uint32_t>(mObjects.size()));
+        if (result.second)
+            mObjects.push_back(object);
+        return result.first->second;
+    }
+
+    const std::vector<const T*>& Objects() const { return mObjects; }
+
+private:
+    std::unordered_map<const T*, std::uint32_t> mIndices;
+    std::vector<const T*> mObjects;
+};
+
+template <typename T>
+std::shared_ptr<T> ObjectAt(const std::vector<std::shared_ptr<T>>& objects, std::uint32_t index)
+{
+    return index == kNone ? nullptr : objects[index];
+}
+
+// Collects the commands replayed into it.
+class PathEncoder final : public Path
+{
+public:
+    void Rect(float x, float y, float width, float height) override { Add(PathCommand::kRect, {x, y, width, height}); }
+    void RoundedRect(float x, float y, float width, float height, float cornerRadiusX, float cornerRadiusY) override
+    {
+        Add(PathCommand::kRoundedRect, {x, y, width, height, cornerRadiusX, cornerRadiusY});
+    }
+    void Ellipse(float cx, float cy, float rx, float ry) override { Add(PathCommand::kEllipse, {cx, cy, rx, ry}); }
+
+    void MoveTo(float x, float y) override { Add(PathCommand::kMoveTo, {x, y}); }
+    void LineTo(float x, float y) override { Add(PathCommand::kLineTo, {x, y}); }
+    void CurveTo(float x1, float y1, float x2, float y2, float x3, float y3) override
+    {
+        Add(PathCommand::kCurveTo, {x1, y1, x2, y2, x3, y3});
+    }
+    void CurveToV(float x2, float y2, float x3, float y3) override { Add(PathCommand::kCurveToV, {x2, y2, x3, y3}); }
+    void ClosePath() override { Add(PathCommand::kClosePath, {}); }
+
+    void Write(BinaryWriter& writer) const
+    {
+        writer.Count(mCommands.size());
+        writer.Count(mValues.size());
+        for (auto command : mCommands)
+            writer.U8(static_cast<std::uint8_t>(command));
+        for (auto value : mValues)
+            writer.Float(value);
+    }
+
+private:
+    void Add(PathCommand command, std::initializer_list<float> values)
+    {
+        mCommands.push_back(command);
+        mValues.insert(mValues.end(), values);
+    }
+
+    std::vector<PathCommand> mCommands;
+    std::vector<float> mValues;
+};
+
+void ReadPath(BinaryReader& reader, Path& path)
+{
+    auto commandCount = reader.Count(1);
+    auto valueCount = reader.Count(0);
+    auto commands = reader.Bytes(commandCount);
+    size_t expectedValueCount{};
+    for (std::uint32_t i = 0; i < commandCount; ++i)
+    {
+        if (commands[i] > static_cast<std::uint8_t>(PathCommand::kClosePath))
+            ThrowInvalid();
+        expectedValueCount += gPathCommandValueCounts[commands[i]];
+    }
+    if (valueCount != expectedValueCount)
+        ThrowInvalid();
+
+    float v[6];
+    for (std::uint32_t i = 0; i < commandCount; ++i)
+    {
+        auto command = static_cast<PathCommand>(commands[i]);
+        for (std::uint8_t j = 0; j < gPathCommandValueCounts[commands[i]]; ++j)
+            v[j] = reader.Float();
+        switch (command)
+        {
+        case PathCommand::kRect:
+            path.Rect(v[0], v[1], v[2], v[3]);
+            break;
+        case PathCommand::kRoundedRect:
+            path.RoundedRect(v[0], v[1], v[2], v[3], v[4], v[5]);
+            break;
+        case PathCommand::kEllipse:
+            path.Ellipse(v[0], v[1], v[2], v[3]);
+            break;
+        case PathCommand::kMoveTo:
+            path.MoveTo(v[0], v[1]);
+            break;
+        case PathCommand::kLineTo:
+            path.LineTo(v[0], v[1]);
+            break;
+        case PathCommand::kCurveTo:
+            path.CurveTo(v[0], v[1], v[2], v[3], v[4], v[5]);
+            break;
+        case PathCommand::kCurveToV:
+            path.CurveToV(v[0], v[1], v[2], v[3]);
+            break;
+        case PathCommand::kClosePath:
+            path.ClosePath();
+            break;
+        }
+    }
+}
+
+void WritePaint(BinaryWriter& writer, const PaintImpl& paint, ObjectTable<GradientImpl>& gradients)
+{
+    if (paint.type() == typeid(std::shared_ptr<const GradientImpl>))
+    {
+        writer.U8(static_cast<std::uint8_t>(PaintTag::kGradient));
+        writer.U32(gradients.Add(boost::get<std::shared_ptr<const GradientImpl>>(paint).get()));
+    }
+    else if (paint.type() == typeid(Variable))
+    {
+        const auto& var = boost::get<Variable>(paint);
+        writer.U8(static_cast<std::uint8_t>(PaintTag::kVariable));
+        writer.String(var.name);
+        writer.Color(var.fallback);
+    }
+    else if (paint.type() == typeid(ColorKeys))
+    {
+        writer.U8(static_cast<std::uint8_t>(PaintTag::kColorKey));
+        writer.U8(static_cast<std::uint8_t>(boost::get<ColorKeys>(paint)));
+    }
+    else
+    {
+        writer.U8(static_cast<std::uint8_t>(PaintTag::kColor));
+        writer.Color(boost::get<Color>(paint));
+    }
+}
+
+PaintImpl ReadPaint(BinaryReader& reader, const std::vector<std::shared_ptr<const GradientImpl>>& gradients)
+{
+    switch (reader.Enum(PaintTag::kColorKey))
+    {
+    case PaintTag::kGradient:
+        return gradients[reader.Index(gradients.size())];
+    case PaintTag::kVariable:
+    {
+        auto name = reader.String();
+        return Variable{std::move(name), reader.Color()};
+    }
+    case PaintTag::kColorKey:
+        return reader.Enum(ColorKeys::kCurrentColor);
+    default:
+        return reader.Color();
+    }
+}
+
+} // namespace
+
+bool SVGDocumentImpl::Serialize(std::vector<char>& data)
+{
+    if (!mOptions.isSerializable)
+        return false;
+#ifdef STYLE_SUPPORT
+    // Style sheets of the document get applied while rendering and have no binary form.
+    if (!mCSSInfo.getElements().empty())
+        return false;
+#endif
+    BuildAllOnce();
+
+    ObjectTable<Transform> transforms;
+    ObjectTable<Path> paths;
+    ObjectTable<ImageSource> imageSources;
+    ObjectTable<ClippingPath> clippingPaths;
+    ObjectTable<GradientImpl> gradients;
+
+    // Sections get written back to front. Each one numbers the shared objects of the
+    // sections before it.
+    BinaryWriter content;
+    content.Count(mGraphicStyles.Size());
+    for (StyleIndex i = 0; i < mGraphicStyles.Size(); ++i)
+    {
+        const auto& graphicStyle = mGraphicStyles[i];
+        content.Float(graphicStyle.opacity);
+        content.U32(transforms.Add(graphicStyle.transform.get()));
+        content.U32(clippingPaths.Add(graphicStyle.clippingPath.get()));
+        content.Bool(graphicStyle.display);
+        content.Float(graphicStyle.stopOpacity);
+        content.ColorImpl(graphicStyle.stopColor);
+    }
+    content.Count(mFillStyles.Size());
+    for (StyleIndex i = 0; i < mFillStyles.Size(); ++i)
+    {
+        const auto& fillStyle = mFillStyles[i];
+        content.Bool(fillStyle.hasFill);
+        content.U8(static_cast<std::uint8_t>(fillStyle.fillRule));
+        content.Float(fillStyle.fillOpacity);
+        WritePaint(content, fillStyle.internalPaint, gradients);
+        content.Bool(fillStyle.visibility);
+        content.ColorImpl(fillStyle.color);
+        content.U8(static_cast<std::uint8_t>(fillStyle.clipRule));
+    }
+    content.Count(mStrokeStyles.Size());
+    for (StyleIndex i = 0; i < mStrokeStyles.Size(); ++i)
+    {
+        const auto& strokeStyle = mStrokeStyles[i];
+        content.Bool(strokeStyle.hasStroke);
+        content.Float(strokeStyle.strokeOpacity);
+        content.Float(strokeStyle.lineWidth);
+        content.U8(static_cast<std::uint8_t>(strokeStyle.lineCap));
+        content.U8(static_cast<std::uint8_t>(strokeStyle.lineJoin));
+        content.Float(strokeStyle.miterLimit);
+        content.Count(strokeStyle.dashArray.size());
+        for (auto dash : strokeStyle.dashArray)
+            content.Float(dash);
+        content.Float(strokeStyle.dashOffset);
+        WritePaint(content, strokeStyle.internalPaint, gradients);
+    }
+    content.Count(mClassNames.Size());
+    for (StyleIndex i = 0; i < mClassNames.Size(); ++i)
+    {
+        const auto& classNames = mClassNames[i];
+        content.Count(classNames.size());
+        for (const auto& className : classNames)
+            content.String(className);
+    }
+    content.Count(mImages.size());
+    for (const auto& image : mImages)
+    {
+        content.U32(imageSources.Add(image.source.get()));
+        content.Rect(image.clipArea);
+        content.Rect(image.fillArea);
+    }
+    content.Count(mPaths.size());
+    for (const auto& path : mPaths)
+        content.U32(paths.Add(path.get()));
+    content.Count(mTrees.size());
+    for (const auto& tree : mTrees)
+    {
+        content.Count(tree.size());
+        for (const auto& node : tree)
+        {
+            content.U8(static_cast<std::uint8_t>(node.type));
+            content.U32(node.graphicStyle);
+            content.U32(node.classNames);
+            content.U32(node.fillStyle);
+            content.U32(node.strokeStyle);
+            content.U32(node.resource);
+            content.U32(node.end);
+        }
+    }
+    content.Count(mIdToElementToMap.size());
+    for (const auto& id : mIdToElementToMap)
+    {
+        content.String(id.first);
+        content.U32(id.second.tree);
+        content.U32(id.second.node);
+    }
+
+    BinaryWriter resources;
+    resources.Count(clippingPaths.Objects().size());
+    for (auto clippingPath : clippingPaths.Objects())
+    {
+        resources.Bool(clippingPath->hasClipContent);
+        resources.U8(static_cast<std::uint8_t>(clippingPath->clipRule));
+        resources.U32(paths.Add(clippingPath->path.get()));
+        resources.U32(transforms.Add(clippingPath->transform.get()));
+    }
+    resources.Count(gradients.Objects().size());
+    for (auto gradient : gradients.Objects())
+    {
+        resources.U8(static_cast<std::uint8_t>(gradient->type));
+        resources.U8(static_cast<std::uint8_t>(gradient->method));
+        for (auto value : {gradient->x1, gradient->y1, gradient->x2, gradient->y2, gradient->cx, gradient->cy, gradient->fx,
+                 gradient->fy, gradient->r})
+            resources.Float(value);
+        resources.U32(transforms.Add(gradient->transform.get()));
+        resources.Count(gradient->internalColorStops.size());
+        for (const auto& colorStop : gradient->internalColorStops)
+        {
+            resources.Float(std::get<0>(colorStop));
+            resources.ColorImpl(std::get<1>(colorStop));
+            resources.Float(std::get<2>(colorStop));
+        }
+    }
+
+    BinaryWriter objects;
+    for (auto c : kMagic)
+        objects.U8(static_cast<std::uint8_t>(c));
+    objects.U32(kVersion);
+    for (auto value : mViewBox)
+        objects.Float(value);
+    objects.Count(transforms.Objects().size());
+    for (auto transform : transforms.Objects())
+    {
+        auto matrix = mTransformMatrices.find(transform);
+        if (matrix == mTransformMatrices.end())
+            return false;
+        for (auto value : matrix->second)
+            objects.Float(value);
+    }
+    // Every shape has a path.
+    if (std::find(mPaths.begin(), mPaths.end(), nullptr) != mPaths.end())
+        return false;
+    objects.Count(paths.Objects().size());
+    for (auto path : paths.Objects())
+    {
+        auto outline = mPathRecordings.find(path);
+        if (outline == mPathRecordings.end())
+            return false;
+        PathEncoder encoder;
+        outline->second.Replay(encoder);
+        encoder.Write(objects);
+    }
+    objects.Count(imageSources.Objects().size());
+    for (auto source : imageSources.Objects())
+    {
+        objects.U8(static_cast<std::uint8_t>(source->encoding));
+        objects.U64(source->decodedSize);
+        objects.String(source->base64);
+    }
+
+    data.clear();
+    data.reserve(objects.Data().size() + resources.Data().size() + content.Data().size());
+    for (const auto* section : {&objects, &resources, &content})
+        data.insert(data.end(), section->Data().begin(), section->Data().end());
+    return true;
+}
+
+void SVGDocumentImpl::Deserialize(const char* data, size_t length)
+{
+    BinaryReader reader(data, length);
+    if (memcmp(reader.Bytes(sizeof(kMagic)), kMagic, sizeof(kMagic)) != 0 || reader.U32() != kVersion)
+        ThrowInvalid();
+    for (auto& value : mViewBox)
+        value = reader.Float();
+
+    std::vector<std::shared_ptr<Transform>> transforms(reader.Count(6 * 4));
+    for (auto& transform : transforms)
+    {
+        std::array<float, 6> matrix;
+        for (auto& value : matrix)
+            value = reader.Float();
+        transform = CreateTransform(matrix);
+    }
+
+    std::vector<std::shared_ptr<Path>> paths(reader.Count(2 * 4));
+    for (auto& path : paths)
+    {
+        if (RecordsGeometry())
+        {
+            PathRecorder outline;
+            ReadPath(reader, outline);
+            path = CreatePath(outline);
+        }
+        else
+        {
+            path = mRenderer->CreatePath();
+            ReadPath(reader, *path);
+        }
+    }
+
+    std::vector<std::shared_ptr<ImageSource>> imageSources(reader.Count(1 + 8 + 4));
+    for (auto& source : imageSources)
+    {
+        source = std::make_shared<ImageSource>();
+        source->encoding = reader.Enum(ImageEncoding::kJPEG);
+        source->decodedSize = static_cast<size_t>(reader.U64());
+        source->base64 = reader.String();
+    }
+
+    std::vector<std::shared_ptr<ClippingPath>> clippingPaths(reader.Count(1 + 1 + 4 + 4));
+    for (auto& clippingPath : clippingPaths)
+    {
+        auto hasClipContent = reader.Bool();
+        auto clipRule = reader.Enum(WindingRule::kEvenOdd);
+        auto path = reader.Index(paths.size(), !hasClipContent);
+        auto transform = reader.Index(transforms.size(), true);
+        clippingPath = std::make_shared<ClippingPath>(hasClipContent, clipRule, ObjectAt(paths, path), ObjectAt(transforms, transform));
+    }
+
+    std::vector<std::shared_ptr<const GradientImpl>> gradients(reader.Count(1 + 1 + 9 * 4 + 4 + 4));
+    for (auto& gradientPaint : gradients)
+    {
+        GradientImpl gradient;
+        gradient.type = reader.Enum(GradientType::kRadialGradient);
+        gradient.method = reader.Enum(SpreadMethod::kRepeat);
+        for (auto value : {&gradient.x1, &gradient.y1, &gradient.x2, &gradient.y2, &gradient.cx, &gradient.cy, &gradient.fx,
+                 &gradient.fy, &gradient.r})
+            *value = reader.Float();
+        gradient.transform = ObjectAt(transforms, reader.Index(transforms.size(), true));
+        gradient.internalColorStops.resize(reader.Count(4 + 1 + 4));
+        for (auto& colorStop : gradient.internalColorStops)
+        {
+            std::get<0>(colorStop) = reader.Float();
+            std::get<1>(colorStop) = reader.ColorImpl();
+            std::get<2>(colorStop) = reader.Float();
+            AssignSlot(std::get<1>(colorStop));
+        }
+        gradientPaint = std::make_shared<const GradientImpl>(std::move(gradient));
+    }
+
+    // Restore the style tables in their original order. Nodes refer to them by index.
+    mGraphicStyles = decltype(mGraphicStyles)();
+    for (auto count = reader.Count(4 + 4 + 4 + 1 + 4 + 1); count; --count)
+    {
+        GraphicStyleImpl graphicStyle;
+        graphicStyle.opacity = reader.Float();
+        graphicStyle.transform = ObjectAt(transforms, reader.Index(transforms.size(), true));
+        graphicStyle.clippingPath = ObjectAt(clippingPaths, reader.Index(clippingPaths.size(), true));
+        graphicStyle.display = reader.Bool();
+        graphicStyle.stopOpacity = reader.Float();
+        graphicStyle.stopColor = reader.ColorImpl();
+        AssignSlot(graphicStyle.stopColor);
+        mGraphicStyles.Append(graphicStyle);
+    }
+    mFillStyles = decltype(mFillStyles)();
+    for (auto count = reader.Count(1 + 1 + 4 + 1 + 1 + 1 + 1); count; --count)
+    {
+        FillStyleImpl fillStyle;
+        fillStyle.hasFill = reader.Bool();
+        fillStyle.fillRule = reader.Enum(WindingRule::kEvenOdd);
+        fillStyle.fillOpacity = reader.Float();
+        fillStyle.internalPaint = ReadPaint(reader, gradients);
+        fillStyle.visibility = reader.Bool();
+        fillStyle.color = reader.ColorImpl();
+        fillStyle.clipRule = reader.Enum(WindingRule::kEvenOdd);
+        AssignSlot(fillStyle.internalPaint);
+        AssignSlot(fillStyle.color);
+        PreResolvePaint(fillStyle);
+        mFillStyles.Append(fillStyle);
+    }
+    mStrokeStyles = decltype(mStrokeStyles)();
+    for (auto count = reader.Count(1 + 4 + 4 + 1 + 1 + 4 + 4 + 4 + 1); count; --count)
+    {
+        StrokeStyleImpl strokeStyle;
+        strokeStyle.hasStroke = reader.Bool();
+        strokeStyle.strokeOpacity = reader.Float();
+        strokeStyle.lineWidth = reader.Float();
+        strokeStyle.lineCap = reader.Enum(LineCap::kSquare);
+        strokeStyle.lineJoin = reader.Enum(LineJoin::kBevel);
+        strokeStyle.miterLimit = reader.Float();
+        strokeStyle.dashArray.resize(reader.Count(4));
+        for (auto& dash : strokeStyle.dashArray)
+            dash = reader.Float();
+        strokeStyle.dashOffset = reader.Float();
+        strokeStyle.internalPaint = ReadPaint(reader, gradients);
+        AssignSlot(strokeStyle.internalPaint);
+        PreResolvePaint(strokeStyle);
+        mStrokeStyles.Append(strokeStyle);
+    }
+    mClassNames = decltype(mClassNames)();
+    for (auto count = reader.Count(4); count; --count)
+    {
+        std::set<std::string> classNames;
+        for (auto nameCount = reader.Count(4); nameCount; --nameCount)
+            classNames.insert(reader.String());
+        mClassNames.Append(classNames);
+    }
+
+    mImages.resize(reader.Count(4 + 2 * 4 * 4));
+    for (auto& image : mImages)
+    {
+        image.source = imageSources[reader.Index(imageSources.size())];
+        image.clipArea = reader.Rect();
+        image.fillArea = reader.Rect();
+    }
+
+    mPaths.resize(reader.Count(4));
+    for (auto& path : mPaths)
+        path = paths[reader.Index(paths.size())];
+
+    // Nodes are only accepted if they form complete subtrees. Rendering relies on that.
+    mTrees.resize(reader.Count(4));
+    if (mTrees.empty())
+        ThrowInvalid();
+    for (auto& tree : mTrees)
+    {
+        tree.resize(reader.Count(1 + 6 * 4));
+        if (tree.empty())
+            ThrowInvalid();
+        std::vector<std::uint32_t> groupEnds;
+        for (std::uint32_t i = 0; i < tree.size(); ++i)
+        {
+            auto& node = tree[i];
+            node.type = reader.Enum(ElementType::kInstance);
+            node.graphicStyle = reader.Index(mGraphicStyles.Size());
+            node.classNames = reader.Index(mClassNames.Size());
+            node.fillStyle = reader.Index(mFillStyles.Size());
+            node.strokeStyle = reader.Index(mStrokeStyles.Size());
+            node.resource = reader.U32();
+            node.end = reader.U32();
+
+            while (!groupEnds.empty() && groupEnds.back() == i)
+                groupEnds.pop_back();
+            auto parentEnd = groupEnds.empty() ? tree.size() : groupEnds.back();
+            if (node.end <= i || node.end > parentEnd || (i == 0 && (node.type != ElementType::kGroup || node.end != tree.size())))
+                ThrowInvalid();
+            if (node.type == ElementType::kGroup)
+            {
+                groupEnds.push_back(node.end);
+                continue;
+            }
+            if (node.end != i + 1)
+                ThrowInvalid();
+            if ((node.type == ElementType::kGraphic && node.resource >= mPaths.size())
+                || (node.type == ElementType::kImage && node.resource >= mImages.size())
+                || (node.type == ElementType::kInstance && node.resource >= mTrees.size()))
+                ThrowInvalid();
+        }
+    }
+
+    // Instances must not contain themselves, directly or through other instances.
+    enum class Visit : std::uint8_t
+    {
+        kNew,
+        kActive,
+        kDone
+    };
+    std::vector<Visit> visits(mTrees.size(), Visit::kNew);
+    for (std::uint32_t root = 0; root < mTrees.size(); ++root)
+    {
+        if (visits[root] != Visit::kNew)
+            continue;
+        // Trees being visited with the next node to look at.
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> stack{{root, 0}};
+        visits[root] = Visit::kActive;
+        while (!stack.empty())
+        {
+            auto treeIndex = stack.back().first;
+            auto& i = stack.back().second;
+            const auto& tree = mTrees[treeIndex];
+            while (i < tree.size() && tree[i].type != ElementType::kInstance)
+                ++i;
+            if (i == tree.size())
+            {
+                visits[treeIndex] = Visit::kDone;
+                stack.pop_back();
+                continue;
+            }
+            auto content = tree[i++].resource;
+            if (visits[content] == Visit::kActive)
+                ThrowInvalid();
+            if (visits[content] == Visit::kNew)
+            {
+                visits[content] = Visit::kActive;
+                stack.emplace_back(content, 0);
+            }
+        }
+    }
+
+    mIdToElementToMap.clear();
+    for (auto count = reader.Count(4 + 4 + 4); count; --count)
+    {
+        auto id = reader.String();
+        auto tree = reader.Index(mTrees.size());
+        auto node = reader.Index(mTrees[tree].size());
+        mIdToElementToMap.emplace(std::move(id), NodeRef{tree, node});
+    }
+
+    if (!reader.AtEnd())
+        ThrowInvalid();
+    mGroupStack = std::stack<NodeRef>();
+}
+
+} // namespace SVGNative
@@ -0,0 +1,287 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+// Conservative bounds of the render tree for culling. Bounds are kept in the
+// coordinates of the root of each tree instead of surface coordinates. That way
+// they stay valid for every size the document gets rendered at, and the content
+// of <use> elements needs bounds only once for all of its instances.
+
+#include "SVGDocumentImpl.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SVGNative
+{
+namespace
+{
+using Matrix = std::array<float, 6>;
+
+const Matrix kIdentity{{1, 0, 0, 1, 0, 0}};
+const auto kNoParent = std::numeric_limits<std::uint32_t>::max();
+
+bool IsEmpty(const Box& box) { return box.minX > box.maxX || box.minY > box.maxY; }
+
+bool IsUnbounded(const Box& box)
+{
+    return std::isinf(box.minX) || std::isinf(box.minY) || std::isinf(box.maxX) || std::isinf(box.maxY);
+}
+
+Box Unbounded()
+{
+    const auto infinity = std::numeric_limits<float>::infinity();
+    Box box;
+    box.minX = box.minY = -infinity;
+    box.maxX = box.maxY = infinity;
+    return box;
+}
+
+void AddPoint(Box& box, float x, float y)
+{
+    box.minX = std::min(box.minX, x);
+    box.minY = std::min(box.minY, y);
+    box.maxX = std::max(box.maxX, x);
+    box.maxY = std::max(box.maxY, y);
+}
+
+void Unite(Box& box, const Box& other)
+{
+    if (IsEmpty(other))
+        return;
+    AddPoint(box, other.minX, other.minY);
+    AddPoint(box, other.maxX, other.maxY);
+}
+
+// Same product as ConcatMatrix() in SVGStringParser.cpp: other applies first.
+Matrix Multiply(const Matrix& m, const Matrix& o)
+{
+    return {{o[0] * m[0] + o[1] * m[2], o[0] * m[1] + o[1] * m[3], o[2] * m[0] + o[3] * m[2], o[2] * m[1] + o[3] * m[3],
+        o[4] * m[0] + o[5] * m[2] + m[4], o[4] * m[1] + o[5] * m[3] + m[5]}};
+}
+
+// Bounds of the transformed corners of box.
+Box TransformBox(const Matrix& m, const Box& box)
+{
+    if (IsEmpty(box) || IsUnbounded(box))
+        return box;
+
+    Box result;
+    for (auto x : {box.minX, box.maxX})
+    {
+        for (auto y : {box.minY, box.maxY})
+            AddPoint(result, m[0] * x + m[2] * y + m[4], m[1] * x + m[3] * y + m[5]);
+    }
+    return result;
+}
+
+bool Intersects(const Box& a, const Box& b)
+{
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+// Path that only tracks the extent of its points. Curves lie within the hull of
+// their control points.
+class BoundsPath final : public Path
+{
+public:
+    void Rect(float x, float y, float width, float height) override
+    {
+        AddPoint(mBox, x, y);
+        AddPoint(mBox, x + width, y + height);
+    }
+
+    void RoundedRect(float x, float y, float width, float height, float, float) override { Rect(x, y, width, height); }
+
+    void Ellipse(float cx, float cy, float rx, float ry) override { Rect(cx - rx, cy - ry, 2 * rx, 2 * ry); }
+
+    void MoveTo(float x, float y) override { AddPoint(mBox, x, y); }
+
+    void LineTo(float x, float y) override { AddPoint(mBox, x, y); }
+
+    void CurveTo(float x1, float y1, float x2, float y2, float x3, float y3) override
+    {
+        AddPoint(mBox, x1, y1);
+        AddPoint(mBox, x2, y2);
+        AddPoint(mBox, x3, y3);
+    }
+
+    void CurveToV(float x2, float y2, float x3, float y3) override
+    {
+        AddPoint(mBox, x2, y2);
+        AddPoint(mBox, x3, y3);
+    }
+
+    void ClosePath() override {}
+
+    const Box& Bounds() const { return mBox; }
+
+private:
+    Box mBox;
+};
+} // namespace
+
+void SVGDocumentImpl::RecordPathBounds(const Path& path, const PathRecorder& outline)
+{
+    BoundsPath bounds;
+    outline.Replay(bounds);
+    mPathBounds[&path] = bounds.Bounds();
+}
+
+bool SVGDocumentImpl::UpdateBounds()
+{
+    if (!mOptions.computeBounds)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mBoundsMutex);
+    mTreeBounds.resize(mTrees.size());
+    for (std::uint32_t tree = 0; tree < mTrees.size(); ++tree)
+        ComputeTreeBounds(tree);
+    return true;
+}
+
+void SVGDocumentImpl::ComputeTreeBounds(std::uint32_t treeIndex)
+{
+    const auto& tree = mTrees[treeIndex];
+    if (mTreeBounds[treeIndex].boxes.size() == tree.size())
+        return;
+
+    TreeBounds treeBounds;
+    treeBounds.boxes.resize(tree.size());
+    // Transform from each node to the root and the parent of each node.
+    std::vector<Matrix> matrices(tree.size());
+    std::vector<std::uint32_t> parents(tree.size(), kNoParent);
+    std::vector<std::uint32_t> groups;
+    for (std::uint32_t i = 0; i < tree.size(); ++i)
+    {
+        while (!groups.empty() && tree[groups.back()].end <= i)
+            groups.pop_back();
+
+        const auto& node = tree[i];
+        const auto& transform = mGraphicStyles[node.graphicStyle].transform;
+        matrices[i] = groups.empty() ? kIdentity : matrices[groups.back()];
+        if (transform)
+        {
+            auto matrix = mTransformMatrices.find(transform.get());
+            if (matrix == mTransformMatrices.end())
+            {
+                // Renderer transforms are opaque. Nothing of the tree may get culled then.
+                treeBounds.boxes.assign(tree.size(), Unbounded());
+                treeBounds.instanceMatrices.clear();
+                mTreeBounds[treeIndex] = std::move(treeBounds);
+                return;
+            }
+            matrices[i] = Multiply(matrices[i], matrix->second);
+        }
+        if (!groups.empty())
+            parents[i] = groups.back();
+
+        auto& box = treeBounds.boxes[i];
+        switch (node.type)
+        {
+        case ElementType::kGraphic:
+            box = TransformBox(matrices[i], GraphicBounds(node));
+            break;
+        case ElementType::kImage:
+        {
+            // The image gets clipped to the fill area.
+            const auto& fillArea = mImages[node.resource].fillArea;
+            if (std::isnan(fillArea.x) || std::isnan(fillArea.y) || std::isnan(fillArea.width) || std::isnan(fillArea.height))
+                box = Unbounded();
+            else
+            {
+                Box local;
+                AddPoint(local, fillArea.x, fillArea.y);
+                AddPoint(local, fillArea.x + fillArea.width, fillArea.y + fillArea.height);
+                box = TransformBox(matrices[i], local);
+            }
+            break;
+        }
+        case ElementType::kGroup:
+            // Gets the union of its children below.
+            groups.push_back(i);
+            break;
+        case ElementType::kInstance:
+            // The content was parsed before the instance, so no tree depends on itself.
+            ComputeTreeBounds(node.resource);
+            box = TransformBox(matrices[i], mTreeBounds[node.resource].boxes.front());
+            treeBounds.instanceMatrices[i] = matrices[i];
+            break;
+        }
+    }
+
+    // Children follow their parents, so all descendants are done when a node is reached.
+    for (auto i = static_cast<std::uint32_t>(tree.size()); i-- > 0;)
+    {
+        if (parents[i] != kNoParent)
+            Unite(treeBounds.boxes[parents[i]], treeBounds.boxes[i]);
+    }
+    mTreeBounds[treeIndex] = std::move(treeBounds);
+}
+
+Box SVGDocumentImpl::GraphicBounds(const Node& node) const
+{
+    auto pathBounds = mPathBounds.find(mPaths[node.resource].get());
+    if (pathBounds == mPathBounds.end())
+        return Unbounded();
+
+    auto box = pathBounds->second;
+    const auto& strokeStyle = mStrokeStyles[node.strokeStyle];
+    if (IsEmpty(box) || !strokeStyle.hasStroke)
+        return box;
+
+    // Miter joins reach up to miterLimit half line widths out, square caps sqrt(2).
+    auto reach = strokeStyle.lineWidth / 2
+        * std::max(strokeStyle.lineJoin == LineJoin::kMiter ? strokeStyle.miterLimit : 1.0f, 1.4142136f);
+    box.minX -= reach;
+    box.minY -= reach;
+    box.maxX += reach;
+    box.maxY += reach;
+    return box;
+}
+
+bool SVGDocumentImpl::IsVisible(const CullArea& cullArea, std::uint32_t tree, std::uint32_t node) const
+{
+    const auto& box = mTreeBounds[tree].boxes[node];
+    if (IsUnbounded(box))
+        return true;
+    if (IsEmpty(box))
+        return false;
+    return Intersects(TransformBox(cullArea.toSurface, box), cullArea.visibleArea);
+}
+
+bool SVGDocumentImpl::InstanceCullArea(const CullArea& cullArea, std::uint32_t tree, std::uint32_t node, CullArea& instanceCullArea) const
+{
+    const auto& instanceMatrices = mTreeBounds[tree].instanceMatrices;
+    auto matrix = instanceMatrices.find(node);
+    if (matrix == instanceMatrices.end())
+        return false;
+
+    instanceCullArea.visibleArea = cullArea.visibleArea;
+    instanceCullArea.toSurface = Multiply(cullArea.toSurface, matrix->second);
+    return true;
+}
+
+bool SVGDocumentImpl::SetCullArea(const Rect& visibleArea, float scale, CullArea& cullArea) const
+{
+    if (!(visibleArea.width >= 0 && visibleArea.height >= 0) || std::isnan(visibleArea.x) || std::isnan(visibleArea.y))
+        return false;
+
+    // A pixel more for antialiasing at the edges.
+    cullArea.visibleArea = Box();
+    AddPoint(cullArea.visibleArea, visibleArea.x - 1, visibleArea.y - 1);
+    AddPoint(cullArea.visibleArea, visibleArea.x + visibleArea.width + 1, visibleArea.y + visibleArea.height + 1);
+    // RenderElement() translates by the origin of the viewBox, then scales.
+    cullArea.toSurface = {{scale, 0, 0, scale, -mViewBox[0], -mViewBox[1]}};
+    return true;
+}
+
+} // namespace SVGNative
@@ -0,0 +1,235 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "SVGDocumentCache.h"
+#include "SVGRenderer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <list>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+
+namespace SVGNative
+{
+namespace
+{
+// MurmurHash64A by Austin Appleby. Reads 8 bytes per step.
+std::uint64_t HashContent(const char* data, size_t length)
+{
+    const std::uint64_t m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+    std::uint64_t hash = 0x9747b28c ^ (length * m);
+
+    auto end = data + (length & ~static_cast<size_t>(7));
+    for (auto p = data; p != end; p += 8)
+    {
+        std::uint64_t k;
+        memcpy(&k, p, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        hash ^= k;
+        hash *= m;
+    }
+
+    auto tail = reinterpret_cast<const unsigned char*>(end);
+    if (auto tailLength = length & 7)
+    {
+        for (size_t i = 0; i < tailLength; ++i)
+            hash ^= static_cast<std::uint64_t>(tail[i]) << (8 * i);
+        hash *= m;
+    }
+
+    hash ^= hash >> r;
+    hash *= m;
+    hash ^= hash >> r;
+    return hash;
+}
+
+// data points to the copy of the content that a cache entry keeps, or to the content
+// passed by the caller while looking it up.
+struct CacheKey
+{
+    std::uint64_t hash;
+    const char* data;
+    size_t length;
+    std::type_index rendererType;
+
+    bool operator==(const CacheKey& other) const
+    {
+        // The hash only narrows down the candidates. Content with colliding hashes must
+        // still get a document of its own.
+        return hash == other.hash && length == other.length && rendererType == other.rendererType
+            && memcmp(data, other.data, length) == 0;
+    }
+};
+
+struct CacheKeyHash
+{
+    size_t operator()(const CacheKey& key) const { return static_cast<size_t>(key.hash) ^ key.rendererType.hash_code(); }
+};
+} // namespace
+
+// LRU list of documents behind one mutex. Parsing happens outside of the lock.
+class SVGDocumentCacheImpl
+{
+public:
+    SVGDocumentCacheImpl(size_t budget, const ParseOptions& options)
+        : mBudget{budget}
+        , mOptions(options)
+    {
+        mOptions.isLazy = false;
+    }
+
+    std::shared_ptr<const SVGDocument> GetDocument(const char* data, size_t length, std::shared_ptr<SVGRenderer> renderer);
+    void Clear();
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mSize;
+    }
+
+    size_t Count() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEntries.size();
+    }
+
+private:
+    using Document = std::shared_ptr<const SVGDocument>;
+
+    struct Entry
+    {
+        CacheKey key;
+        std::unique_ptr<char[]> content;
+        Document document;
+        size_t size;
+    };
+
+    void Evict();
+
+    const size_t mBudget;
+    ParseOptions mOptions;
+
+    mutable std::mutex mMutex;
+    // Most recently used first.
+    std::list<Entry> mEntries;
+    std::unordered_map<CacheKey, std::list<Entry>::iterator, CacheKeyHash> mIndex;
+    // Documents that are being parsed by another thread.
+    std::unordered_map<CacheKey, std::shared_future<Document>, CacheKeyHash> mPending;
+    size_t mSize{};
+};
+
+std::shared_ptr<const SVGDocument> SVGDocumentCacheImpl::GetDocument(
+    const char* data, size_t length, std::shared_ptr<SVGRenderer> renderer)
+{
+    if (!data || !renderer)
+        return nullptr;
+
+    CacheKey key{HashContent(data, length), data, length, std::type_index(typeid(*renderer))};
+    std::promise<Document> promise;
+    std::shared_future<Document> pending;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mIndex.find(key);
+        if (it != mIndex.end())
+        {
+            mEntries.splice(mEntries.begin(), mEntries, it->second);
+            return it->second->document;
+        }
+
+        auto pendingIt = mPending.find(key);
+        if (pendingIt != mPending.end())
+            pending = pendingIt->second;
+        else
+            mPending.emplace(key, promise.get_future().share());
+    }
+    // Wait for the thread that parses the same content.
+    if (pending.valid())
+        return pending.get();
+
+    // Threads waiting for the document must get an answer in any case.
+    Document document;
+    std::unique_ptr<char[]> content;
+    size_t size{};
+    try
+    {
+        document = SVGDocument::CreateSVGDocument(data, length, renderer, mOptions);
+        // Documents larger than the whole budget are not worth evicting everything else.
+        size = document ? length + document->MemoryEstimate() : 0;
+        if (document && size <= mBudget)
+        {
+            content.reset(new char[length]);
+            memcpy(content.get(), data, length);
+        }
+    }
+    catch (...)
+    {
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending.erase(key);
+        if (content)
+        {
+            key.data = content.get();
+            mEntries.push_front({key, std::move(content), document, size});
+            mIndex[key] = mEntries.begin();
+            mSize += size;
+            Evict();
+        }
+    }
+    promise.set_value(document);
+    return document;
+}
+
+void SVGDocumentCacheImpl::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mIndex.clear();
+    mEntries.clear();
+    mSize = 0;
+}
+
+void SVGDocumentCacheImpl::Evict()
+{
+    while (mSize > mBudget && !mEntries.empty())
+    {
+        const auto& entry = mEntries.back();
+        mSize -= entry.size;
+        mIndex.erase(entry.key);
+        mEntries.pop_back();
+    }
+}
+
+SVGDocumentCache::SVGDocumentCache(size_t budget, const ParseOptions& options)
+    : mCache{new SVGDocumentCacheImpl(budget, options)}
+{
+}
+
+SVGDocumentCache::~SVGDocumentCache() {}
+
+std::shared_ptr<const SVGDocument> SVGDocumentCache::GetDocument(const char* data, size_t length, std::shared_ptr<SVGRenderer> renderer)
+{
+    return mCache->GetDocument(data, length, std::move(renderer));
+}
+
+void SVGDocumentCache::Clear() { mCache->Clear(); }
+
+size_t SVGDocumentCache::Size() const { return mCache->Size(); }
+
+size_t SVGDocumentCache::Count() const { return mCache->Count(); }
+
+} // namespace SVGNative
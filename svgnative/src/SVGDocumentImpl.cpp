@@ -12,50 +12,48 @@ governing permissions and limitations under the License.
 
 #include "SVGDocumentImpl.h"
 #include "SVGDocument.h"
+#include "SVGElementNames.h"
 #include "SVGRenderer.h"
 #include "SVGStringParser.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cmath>
+#include <cstring>
+#include <exception>
 #include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+using namespace boost::property_tree::detail::rapidxml;
 
 namespace SVGNative
 {
-constexpr std::array<const char*, 14> gInheritedPropertyNames{{
-    "color",
-    "clip-rule",
-    "fill",
-    "fill-rule",
-    "fill-opacity",
-    "stroke",
-    "stroke-dasharray",
-    "stroke-dashoffset",
-    "stroke-linecap",
-    "stroke-linejoin",
-    "stroke-miterlimit",
-    "stroke-opacity",
-    "stroke-width",
-    "visibility"
-}};
-
-constexpr std::array<const char*, 5> gNonInheritedPropertyNames{{
-    "clip-path",
-    "display",
-    "opacity",
-    "stop-opacity",
-    "stop-color"
-}};
-
-SVGDocumentImpl::SVGDocumentImpl(std::shared_ptr<SVGRenderer> renderer)
+bool ReadImageSize(const std::string& base64, float& width, float& height);
+
+// Compares an unparsed property value with a keyword.
+static bool IsValue(const PropertyValue& property, const char* keyword)
+{
+    auto length = strlen(keyword);
+    return property.length == length && memcmp(property.value, keyword, length) == 0;
+}
+
+SVGDocumentImpl::SVGDocumentImpl(std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options)
     : mViewBox{{0, 0, 320.0f, 200.0f}}
     , mRenderer{renderer}
+    , mOptions(options)
+    , mBudget(options.limits)
 {
-    mFillStyleStack.push(FillStyleImpl());
-    mStrokeStyleStack.push(StrokeStyleImpl());
-
-    GraphicStyleImpl graphicStyle{};
-    std::set<std::string> classNames;
-    mGroup = std::make_shared<Group>(graphicStyle, classNames);
-    mGroupStack.push(mGroup);
+    FillStyleImpl fillStyle;
+    PreResolvePaint(fillStyle);
+    mFillStyleStack.push(mFillStyles.Intern(fillStyle));
+    StrokeStyleImpl strokeStyle;
+    PreResolvePaint(strokeStyle);
+    mStrokeStyleStack.push(mStrokeStyles.Intern(strokeStyle));
+
+    OpenTree();
 }
 
 template <typename T>
@@ -64,12 +62,191 @@ bool isCloseToZero(T x)
     return std::abs(x) < std::numeric_limits<T>::epsilon();
 }
 
+// Appends the code point as UTF-8 like RapidXML does for character references.
+static void AppendUTF8(std::string& output, unsigned long code)
+{
+    if (code < 0x80)
+        output += static_cast<char>(code);
+    else if (code < 0x800)
+    {
+        output += static_cast<char>(0xC0 | (code >> 6));
+        output += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000)
+    {
+        output += static_cast<char>(0xE0 | (code >> 12));
+        output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x110000)
+    {
+        output += static_cast<char>(0xF0 | (code >> 18));
+        output += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else
+        throw std::runtime_error("Invalid numeric character entity");
+}
+
+// Replaces the predefined entities and character references in text. Unknown
+// entities stay as they are.
+static std::string TranslateReferences(const char* text, size_t length)
+{
+    static const struct
+    {
+        const char* name;
+        char character;
+    } entities[] = {{"amp;", '&'}, {"apos;", '\''}, {"quot;", '"'}, {"gt;", '>'}, {"lt;", '<'}};
+
+    std::string output;
+    output.reserve(length);
+    const char* end = text + length;
+    while (text < end)
+    {
+        if (*text != '&')
+        {
+            output += *text++;
+            continue;
+        }
+
+        const char* pos = text + 1;
+        if (pos < end && *pos == '#')
+        {
+            bool isHex = ++pos < end && *pos == 'x';
+            if (isHex)
+                ++pos;
+            unsigned long code{};
+            for (; pos < end && std::isxdigit(static_cast<unsigned char>(*pos)); ++pos)
+            {
+                if (!isHex && !std::isdigit(static_cast<unsigned char>(*pos)))
+                    break;
+                auto digit = std::isdigit(static_cast<unsigned char>(*pos)) ? *pos - '0' : (std::tolower(*pos) - 'a' + 10);
+                code = std::min(code * (isHex ? 16 : 10) + digit, 0x110000ul);
+            }
+            if (pos == end || *pos != ';')
+                throw std::runtime_error("Expected ; after character reference");
+            AppendUTF8(output, code);
+            text = pos + 1;
+            continue;
+        }
+
+        bool isEntity{};
+        for (const auto& entity : entities)
+        {
+            auto nameLength = strlen(entity.name);
+            if (static_cast<size_t>(end - pos) >= nameLength && memcmp(pos, entity.name, nameLength) == 0)
+            {
+                output += entity.character;
+                text = pos + nameLength;
+                isEntity = true;
+                break;
+            }
+        }
+        if (!isEntity)
+            output += *text++;
+    }
+    return output;
+}
+
+void SVGDocumentImpl::ParseXML(const char* text)
+{
+    SVG_ASSERT(text != nullptr);
+
+    mBudget.CheckDepth(text);
+
+    // Parse without terminating strings or translating entities. RapidXML leaves text
+    // untouched then, so it may be read-only. Names and values point into text and
+    // must be read with name_size() and value_size().
+    mXMLDocument.parse<parse_non_destructive>(const_cast<char*>(text));
+    TranslateEntities();
+}
+
+void SVGDocumentImpl::TranslateEntities()
+{
+    // Points value to a translated copy in the memory pool of the XML document if the
+    // text has references.
+    auto translate = [this](const char*& value, size_t& size) {
+        if (!memchr(value, '&', size))
+            return false;
+        auto translated = TranslateReferences(value, size);
+        size = translated.size();
+        value = mXMLDocument.allocate_string(translated.data(), size);
+        return true;
+    };
+
+    // Walk the DOM without recursion.
+    XMLNode* node = mXMLDocument.first_node();
+    while (node)
+    {
+        if (node->type() == node_element || node->type() == node_data)
+        {
+            const char* value = node->value();
+            size_t size = node->value_size();
+            if (translate(value, size))
+                node->value(value, size);
+            for (auto attr = node->first_attribute(); attr; attr = attr->next_attribute())
+            {
+                value = attr->value();
+                size = attr->value_size();
+                if (translate(value, size))
+                    attr->value(value, size);
+            }
+        }
+
+        if (node->first_node())
+        {
+            node = node->first_node();
+            continue;
+        }
+        while (node && node != &mXMLDocument && !node->next_sibling())
+            node = node->parent();
+        node = node && node != &mXMLDocument ? node->next_sibling() : nullptr;
+    }
+}
+
 void SVGDocumentImpl::TraverseSVGTree()
 {
     auto rootNode = mXMLDocument.first_node();
-    if (!rootNode || std::string(rootNode->name()) != "svg")
+    if (!rootNode || !ParseRoot(rootNode))
         return;
 
+    mBudget.Start();
+    mUseTargets.clear();
+
+    if (mOptions.isLazy)
+    {
+        // <symbol> changes the viewBox of the document for everything parsed after it.
+        // Build those documents right away.
+        mIsLazy = true;
+        if (IndexChildren(rootNode))
+            return;
+        mIsLazy = false;
+        mLazyElements.clear();
+        mGradients.clear();
+        mGradientPaints.clear();
+        mResourceIDs.clear();
+        mClippingPaths.clear();
+#ifdef STYLE_SUPPORT
+        mCSSInfo = StyleSheet::CssDocument();
+#endif
+    }
+
+    PreparsePaths(rootNode);
+    ParseChildren(rootNode);
+    mPreparsedPathIndex.clear();
+    mPreparsedPaths.clear();
+
+    FinishParsing();
+}
+
+bool SVGDocumentImpl::ParseRoot(XMLNode* rootNode)
+{
+    SVG_ASSERT(rootNode != nullptr);
+
+    if (GetElementTag(rootNode->name(), rootNode->name_size()) != ElementTag::kSVG)
+        return false;
+
     if (!HasAttr(rootNode, "viewBox"))
     {
         if (HasAttr(rootNode, "x"))
@@ -85,7 +262,7 @@ void SVGDocumentImpl::TraverseSVGTree()
     {
         auto attr = rootNode->first_attribute("viewBox");
         std::vector<float> numberList;
-        if (SVGStringParser::ParseListOfNumbers(std::string(attr->value()), numberList) && numberList.size() == 4)
+        if (SVGStringParser::ParseListOfNumbers(attr->value(), attr->value_size(), numberList) && numberList.size() == 4)
             mViewBox = {{numberList[0], numberList[1], numberList[2], numberList[3]}};
     }
 
@@ -94,16 +271,166 @@ void SVGDocumentImpl::TraverseSVGTree()
     {
         auto attr = rootNode->first_attribute("data-name");
         if (attr)
-            mTitle = attr->value();
+            mTitle = std::string(attr->value(), attr->value_size());
     }
 #endif
 
-    ParseChildren(rootNode);
+    return true;
+}
+
+void SVGDocumentImpl::ParseGroupStart(XMLNode* node)
+{
+    SVG_ASSERT(node != nullptr);
+
+    auto fillStyle = mFillStyleStack.top();
+    auto strokeStyle = mStrokeStyleStack.top();
+    std::set<std::string> classNames;
+    auto graphicStyle = ParseGraphic(node, fillStyle, strokeStyle, classNames);
+
+    std::string idString;
+    if (auto idAttr = node->first_attribute("id"))
+        idString = std::string(idAttr->value(), idAttr->value_size());
+
+    PushGroup(graphicStyle, classNames, fillStyle, strokeStyle, std::move(idString));
+}
+
+void SVGDocumentImpl::ParseGroupEnd()
+{
+    PopGroup();
+}
+
+void SVGDocumentImpl::StartPass()
+{
+    mBudget.Start();
+}
+
+void SVGDocumentImpl::ParseDefsStart(XMLNode* node)
+{
+    SVG_ASSERT(node != nullptr);
+
+    auto fillStyle = mFillStyleStack.top();
+    auto strokeStyle = mStrokeStyleStack.top();
+    std::set<std::string> classNames;
+    ParseGraphic(node, fillStyle, strokeStyle, classNames);
+
+    PushDefs(fillStyle, strokeStyle);
+}
+
+void SVGDocumentImpl::ParseDefsEnd()
+{
+    PopDefs();
+}
+
+void SVGDocumentImpl::ParseSymbolStart(XMLNode* node)
+{
+    SVG_ASSERT(node != nullptr);
+
+    auto fillStyle = mFillStyleStack.top();
+    auto strokeStyle = mStrokeStyleStack.top();
+    std::set<std::string> classNames;
+    auto graphicStyle = ParseGraphic(node, fillStyle, strokeStyle, classNames);
+
+    std::string idString;
+    if (auto idAttr = node->first_attribute("id"))
+        idString = std::string(idAttr->value(), idAttr->value_size());
+
+    PushSymbol(node, graphicStyle, classNames, std::move(idString));
+}
 
+void SVGDocumentImpl::ParseSymbolEnd()
+{
+    CloseGroup();
+    CloseGroup();
+}
+
+void SVGDocumentImpl::ParseFragment(const char* text, size_t length, bool isResource)
+{
+    SVG_ASSERT(text != nullptr);
+
+    auto fragment = std::unique_ptr<XMLDocument>(new XMLDocument);
+    auto buffer = fragment->allocate_string(nullptr, length + 1);
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    fragment->parse<0>(buffer); // 0 means default parse flags
+
+    auto node = fragment->first_node();
+    if (!node)
+        return;
+
+    mHasNewResource = false;
+    if (isResource)
+        ParseResource(node);
+    else
+        ParseChild(node);
+    // <use> elements reference resources by their XML node. Keep the fragment
+    // alive as long as resources may point into it.
+    if (mHasNewResource)
+        mFragments.push_back(std::move(fragment));
+}
+
+void SVGDocumentImpl::FinishParsing()
+{
     // Clear all temporary sets
+    mGraphicStyles.ReleaseLookup();
+    mFillStyles.ReleaseLookup();
+    mStrokeStyles.ReleaseLookup();
+    mClassNames.ReleaseLookup();
     mGradients.clear();
+    mGradientPaints.clear();
     mResourceIDs.clear();
     mClippingPaths.clear();
+    mFragments.clear();
+    mUseContents.clear();
+    mSharedPaths.clear();
+}
+
+void SVGDocumentImpl::PushGroup(const GraphicStyleImpl& graphicStyle, const std::set<std::string>& classNames,
+    StyleIndex fillStyle, StyleIndex strokeStyle, std::string idString)
+{
+    mFillStyleStack.push(fillStyle);
+    mStrokeStyleStack.push(strokeStyle);
+
+    OpenGroup(CreateNode(ElementType::kGroup, graphicStyle, classNames), std::move(idString));
+}
+
+void SVGDocumentImpl::PopGroup()
+{
+    CloseGroup();
+    mFillStyleStack.pop();
+    mStrokeStyleStack.pop();
+}
+
+void SVGDocumentImpl::PushDefs(StyleIndex fillStyle, StyleIndex strokeStyle)
+{
+    mFillStyleStack.push(fillStyle);
+    mStrokeStyleStack.push(strokeStyle);
+}
+
+void SVGDocumentImpl::PopDefs()
+{
+    mFillStyleStack.pop();
+    mStrokeStyleStack.pop();
+}
+
+void SVGDocumentImpl::PushSymbol(XMLNode* node, GraphicStyleImpl& graphicStyle, std::set<std::string>& classNames,
+    std::string idString)
+{
+    auto attr = node->first_attribute("viewBox");
+    if (attr)
+    {
+        std::vector<float> numberList;
+        if (SVGStringParser::ParseListOfNumbers(attr->value(), attr->value_size(), numberList) && numberList.size() == 4)
+        {
+            graphicStyle.transform = CreateTransform({{1, 0, 0, 1, -numberList[0], -numberList[1]}});
+            mViewBox = {{numberList[0], numberList[1], numberList[2], numberList[3]}};
+            ResolveGradients();
+        }
+    }
+
+    // <symbol> is not rendered where it is defined. Keep it in a tree of its own
+    // for rendering it by id.
+    OpenTree();
+    OpenGroup(CreateNode(ElementType::kGroup, graphicStyle, classNames), std::move(idString));
 }
 
 bool SVGDocumentImpl::HasAttr(XMLNode* node, const char* attrName)
@@ -144,12 +471,43 @@ float SVGDocumentImpl::ParseLengthFromAttr(XMLNode* node, const char* attrName,
         return fallback;
 
     float number{};
-    if (!SVGStringParser::ParseLengthOrPercentage(attr->value(), RelativeLength(lengthType), number, true))
+    if (!SVGStringParser::ParseLengthOrPercentage(attr->value(), attr->value_size(), RelativeLength(lengthType), number, true))
         return fallback;
 
     return number;
 }
 
+std::unique_ptr<Transform> SVGDocumentImpl::ParseTransform(const char* transformString, size_t length)
+{
+    SVGStringParser::TransformMatrix matrix;
+    if (!SVGStringParser::ParseTransform(transformString, length, matrix))
+        return nullptr;
+
+    return CreateTransform(matrix);
+}
+
+std::unique_ptr<Transform> SVGDocumentImpl::CreateTransform(const std::array<float, 6>& matrix)
+{
+    SVG_ASSERT(mRenderer != nullptr);
+    auto transform = mRenderer->CreateTransform(matrix[0], matrix[1], matrix[2], matrix[3], matrix[4], matrix[5]);
+    if (RecordsGeometry() && transform)
+        mTransformMatrices[transform.get()] = matrix;
+    return transform;
+}
+
+void SVGDocumentImpl::ConcatTransform(Transform& transform, const Transform& other)
+{
+    transform.Concat(other);
+    if (!RecordsGeometry())
+        return;
+
+    // Same product as ConcatMatrix() in SVGStringParser.cpp.
+    auto& m = mTransformMatrices[&transform];
+    const auto& o = mTransformMatrices[&other];
+    m = {{o[0] * m[0] + o[1] * m[2], o[0] * m[1] + o[1] * m[3], o[2] * m[0] + o[3] * m[2], o[2] * m[1] + o[3] * m[3],
+        o[4] * m[0] + o[5] * m[2] + m[4], o[4] * m[1] + o[5] * m[3] + m[5]}};
+}
+
 void SVGDocumentImpl::ParseChildren(XMLNode* node)
 {
     SVG_ASSERT(node != nullptr);
@@ -160,10 +518,143 @@ void SVGDocumentImpl::ParseChildren(XMLNode* node)
     }
 }
 
+bool SVGDocumentImpl::IndexChildren(XMLNode* node)
+{
+    SVG_ASSERT(node != nullptr);
+
+    // Visits the same elements as ParseChildren() but only parses resources.
+    for (auto child = node->first_node(); child != nullptr; child = child->next_sibling())
+    {
+        auto elementTag = GetElementTag(child->name(), child->name_size());
+        switch (elementTag)
+        {
+        case ElementTag::kSymbol:
+            return false;
+        case ElementTag::kStyle:
+        case ElementTag::kLinearGradient:
+        case ElementTag::kRadialGradient:
+        case ElementTag::kClipPath:
+            ParseResource(child);
+            continue;
+        case ElementTag::kDefs:
+        case ElementTag::kG:
+        {
+            auto fillStyle = mFillStyleStack.top();
+            auto strokeStyle = mStrokeStyleStack.top();
+            std::set<std::string> classNames;
+            ParseGraphic(child, fillStyle, strokeStyle, classNames);
+
+            mFillStyleStack.push(fillStyle);
+            mStrokeStyleStack.push(strokeStyle);
+            bool result{true};
+            if (elementTag == ElementTag::kDefs)
+                ParseResources(child);
+            else
+                result = IndexChildren(child);
+            mFillStyleStack.pop();
+            mStrokeStyleStack.pop();
+            if (!result)
+                return false;
+            break;
+        }
+        case ElementTag::kUnknown:
+        case ElementTag::kSVG:
+        case ElementTag::kStop:
+            continue;
+        default:
+            break;
+        }
+
+        // The first element with a given id wins, as in AddChildToCurrentGroup().
+        if (auto idAttr = child->first_attribute("id"))
+            mLazyElements.emplace(std::string(idAttr->value(), idAttr->value_size()), child);
+    }
+    return true;
+}
+
+void SVGDocumentImpl::BuildElement(XMLNode* node)
+{
+    SVG_ASSERT(node != nullptr);
+
+    // Restore the inherited fill and stroke properties of all ancestor groups.
+    std::vector<XMLNode*> ancestors;
+    auto rootNode = mXMLDocument.first_node();
+    for (auto parent = node->parent(); parent != nullptr && parent != rootNode; parent = parent->parent())
+        ancestors.push_back(parent);
+
+    auto fillStyleDepth = mFillStyleStack.size();
+    auto strokeStyleDepth = mStrokeStyleStack.size();
+    auto groupDepth = mGroupStack.size();
+    mBudget.Start();
+    mUseTargets.clear();
+    try
+    {
+        for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it)
+        {
+            auto fillStyle = mFillStyleStack.top();
+            auto strokeStyle = mStrokeStyleStack.top();
+            std::set<std::string> classNames;
+            ParseGraphic(*it, fillStyle, strokeStyle, classNames);
+            mFillStyleStack.push(fillStyle);
+            mStrokeStyleStack.push(strokeStyle);
+        }
+
+        // The element only needs to get into mIdToElementToMap. Attach it to a
+        // tree of its own.
+        OpenTree();
+        ParseChild(node);
+    }
+    catch (...)
+    {
+    }
+
+    while (mFillStyleStack.size() > fillStyleDepth)
+        mFillStyleStack.pop();
+    while (mStrokeStyleStack.size() > strokeStyleDepth)
+        mStrokeStyleStack.pop();
+    while (mGroupStack.size() > groupDepth)
+        CloseGroup();
+}
+
+void SVGDocumentImpl::BuildAll()
+{
+    SVG_ASSERT(mIsLazy);
+
+    if (auto rootNode = mXMLDocument.first_node())
+    {
+        mBudget.Start();
+        mUseTargets.clear();
+        try
+        {
+            ParseChildren(rootNode);
+        }
+        catch (...)
+        {
+        }
+    }
+
+    mIsLazy = false;
+    mLazyElements.clear();
+    FinishParsing();
+    mXMLDocument.clear();
+}
+
+void SVGDocumentImpl::BuildAllOnce()
+{
+    if (!mIsLazy)
+        return;
+
+    std::lock_guard<std::mutex> lock(mBuildMutex);
+    if (mIsLazy)
+        BuildAll();
+}
+
 void SVGDocumentImpl::ParseChild(XMLNode* child)
 {
     SVG_ASSERT(child != nullptr);
 
+    mBudget.AddElement();
+
     auto fillStyle = mFillStyleStack.top();
     auto strokeStyle = mStrokeStyleStack.top();
     std::set<std::string> classNames;
@@ -171,76 +662,102 @@ void SVGDocumentImpl::ParseChild(XMLNode* child)
 
     std::string idString;
     if (auto idAttr = child->first_attribute("id"))
-        idString = idAttr->value();
+        idString = std::string(idAttr->value(), idAttr->value_size());
+
+    auto elementTag = GetElementTag(child->name(), child->name_size());
 
     // Check if we have a shape rect, circle, ellipse, line, polygon, polyline
     // or path first.
-    if (auto path = ParseShape(child))
+    if (auto path = ParseShape(child, elementTag))
     {
-        AddChildToCurrentGroup(std::unique_ptr<Graphic>(new Graphic(graphicStyle, classNames, fillStyle, strokeStyle, std::move(path))), std::move(idString));
+        auto graphic = CreateNode(ElementType::kGraphic, graphicStyle, classNames);
+        graphic.fillStyle = fillStyle;
+        graphic.strokeStyle = strokeStyle;
+        graphic.resource = static_cast<std::uint32_t>(mPaths.size());
+        mPaths.push_back(std::move(path));
+        AddChildToCurrentGroup(graphic, std::move(idString));
         return;
     }
 
     // Look at all elements that are no shapes.
-    std::string elementName = child->name();
-    if (elementName == "g")
+    if (elementTag == ElementTag::kG)
     {
-        mFillStyleStack.push(fillStyle);
-        mStrokeStyleStack.push(strokeStyle);
-
-        auto group = std::make_shared<Group>(graphicStyle, classNames);
-        AddChildToCurrentGroup(group, std::move(idString));
-        mGroupStack.push(group);
+        PushGroup(graphicStyle, classNames, fillStyle, strokeStyle, std::move(idString));
 
         ParseChildren(child);
 
-        mGroupStack.pop();
-        mFillStyleStack.pop();
-        mStrokeStyleStack.pop();
+        PopGroup();
     }
-    else if (elementName == "defs")
+    else if (elementTag == ElementTag::kDefs)
     {
-        mFillStyleStack.push(fillStyle);
-        mStrokeStyleStack.push(strokeStyle);
+        // Lazy documents parsed all resources already.
+        if (mIsLazy)
+            return;
+
+        PushDefs(fillStyle, strokeStyle);
 
         ParseResources(child);
 
-        mFillStyleStack.pop();
-        mStrokeStyleStack.pop();
+        PopDefs();
     }
-    else if (elementName == "image")
+    else if (elementTag == ElementTag::kImage)
     {
-        std::unique_ptr<ImageData> imageData;
+        std::shared_ptr<ImageSource> source;
+        float imageWidth{};
+        float imageHeight{};
         auto hrefAttr = child->first_attribute("xlink:href");
         if (hrefAttr)
         {
-            std::string dataURL = hrefAttr->value();
+            const char* dataURL = hrefAttr->value();
+            size_t dataURLSize = hrefAttr->value_size();
             ImageEncoding encoding{};
             size_t base64Offset{};
-            if (dataURL.find("data:image/png;base64,") == 0)
+            if (dataURLSize >= 22 && memcmp(dataURL, "data:image/png;base64,", 22) == 0)
             {
                 encoding = ImageEncoding::kPNG;
                 base64Offset = 22;
             }
-            else if (dataURL.find("data:image/jpg;base64,") == 0)
+            else if (dataURLSize >= 22 && memcmp(dataURL, "data:image/jpg;base64,", 22) == 0)
             {
                 encoding = ImageEncoding::kJPEG;
                 base64Offset = 22;
             }
-            else if (dataURL.find("data:image/jpeg;base64,") == 0)
+            else if (dataURLSize >= 23 && memcmp(dataURL, "data:image/jpeg;base64,", 23) == 0)
             {
                 encoding = ImageEncoding::kJPEG;
                 base64Offset = 23;
             }
             else
                 return;
-            imageData = mRenderer->CreateImageData(dataURL.substr(base64Offset), encoding);
+
+            // Keep the encoded data only. Line breaks are common in base64 data
+            // but no decoder needs them.
+            source = std::make_shared<ImageSource>();
+            source->encoding = encoding;
+            source->base64.reserve(dataURLSize - base64Offset);
+            for (auto c = dataURL + base64Offset; c != dataURL + dataURLSize; ++c)
+            {
+                if (*c != ' ' && *c != '\t' && *c != '\r' && *c != '\n')
+                    source->base64.push_back(*c);
+            }
+
+            // The intrinsic size is in the image header. Images with unknown or damaged
+            // headers get decoded once to learn their size. The result is not kept, so
+            // they are decoded on first draw and count against the cache like any other.
+            if (!ReadImageSize(source->base64, imageWidth, imageHeight))
+            {
+                auto decoded = mRenderer->CreateImageData(source->base64, source->encoding);
+                if (!decoded)
+                    return;
+                imageWidth = decoded->Width();
+                imageHeight = decoded->Height();
+            }
+            source->decodedSize = static_cast<size_t>(imageWidth) * static_cast<size_t>(imageHeight) * 4;
+            mBudget.AddImage(source->decodedSize);
         }
 
-        if (imageData)
+        if (source)
         {
-            float imageWidth = imageData->Width();
-            float imageHeight = imageData->Height();
 
             Rect clipArea{ParseLengthFromAttr(child, "x", LengthType::kHorizontal),
                 ParseLengthFromAttr(child, "y", LengthType::kVertical),
@@ -251,7 +768,8 @@ void SVGDocumentImpl::ParseChild(XMLNode* child)
             std::string meetOrSlice;
             std::vector<std::string> attrStringValues;
             auto preserveAspectRatioAttr = child->first_attribute("preserveAspectRatio");
-            if (preserveAspectRatioAttr && SVGStringParser::ParseListOfStrings(preserveAspectRatioAttr->value(), attrStringValues)
+            if (preserveAspectRatioAttr && SVGStringParser::ParseListOfStrings(
+                    preserveAspectRatioAttr->value(), preserveAspectRatioAttr->value_size(), attrStringValues)
                 && attrStringValues.size() >= 1 && attrStringValues.size() <= 2)
             {
                 align = attrStringValues[0];
@@ -324,74 +842,238 @@ void SVGDocumentImpl::ParseChild(XMLNode* child)
             // Do not render 0-sized elements.
             if (imageWidth && imageHeight && clipArea.width && clipArea.height && fillArea.width && fillArea.height)
             {
-                auto image = std::unique_ptr<Image>(new Image(graphicStyle, classNames, std::move(imageData), clipArea, fillArea));
-                AddChildToCurrentGroup(std::move(image), std::move(idString));
+                auto image = CreateNode(ElementType::kImage, graphicStyle, classNames);
+                image.resource = static_cast<std::uint32_t>(mImages.size());
+                mImages.push_back({std::move(source), clipArea, fillArea});
+                AddChildToCurrentGroup(image, std::move(idString));
             }
         }
     }
-    else if (elementName == "use")
+    else if (elementTag == ElementTag::kUse)
     {
         auto href = child->first_attribute("xlink:href");
         if (!href)
             return;
 
-        if (href->value()[0] != '#')
+        if (href->value_size() == 0 || href->value()[0] != '#')
             return;
 
-        auto resourceIt = mResourceIDs.find((href->value() + 1));
+        auto resourceIt = mResourceIDs.find(std::string(href->value() + 1, href->value_size() - 1));
         if (resourceIt == mResourceIDs.end())
             return;
 
-        mFillStyleStack.push(fillStyle);
-        mStrokeStyleStack.push(strokeStyle);
+        // Content that references itself would get instantiated endlessly.
+        auto target = resourceIt->second;
+        if (std::find(mUseTargets.begin(), mUseTargets.end(), target) != mUseTargets.end())
+            return;
+        auto useDepth = mUseTargets.size() + 1;
+        mBudget.AddUse(useDepth);
 
-        auto transform = mRenderer->CreateTransform(
-            1, 0, 0, 1, ParseLengthFromAttr(child, "x", LengthType::kHorizontal), ParseLengthFromAttr(child, "y", LengthType::kVertical));
+        auto transform = CreateTransform(
+            {{1, 0, 0, 1, ParseLengthFromAttr(child, "x", LengthType::kHorizontal), ParseLengthFromAttr(child, "y", LengthType::kVertical)}});
         if (graphicStyle.transform)
-            transform->Concat(*graphicStyle.transform);
+            ConcatTransform(*transform, *graphicStyle.transform);
         graphicStyle.transform = std::move(transform);
 
-        auto group = std::make_shared<Group>(graphicStyle, classNames);
-        mGroupStack.push(group);
-        AddChildToCurrentGroup(group, std::move(idString));
-
-        if(resourceIt->second->first_node() == 0)
-            ParseChild(resourceIt->second);
-        else
-            ParseChildren(resourceIt->second);
-
-        mGroupStack.pop();
-        mFillStyleStack.pop();
-        mStrokeStyleStack.pop();
+        auto instance = CreateNode(ElementType::kInstance, graphicStyle, classNames);
+        instance.resource = ParseUseContent(target, fillStyle, strokeStyle, useDepth);
+        AddChildToCurrentGroup(instance, std::move(idString));
     }
-    else if (elementName == "symbol")
+    else if (elementTag == ElementTag::kSymbol)
     {
         // FIXME: Do not render <symbol> outside of <defs> section.
         // FIXME: Remove support for symbol ASAP.
-        auto attr = child->first_attribute("viewBox");
-        if (attr)
+        PushSymbol(child, graphicStyle, classNames, std::move(idString));
+
+        ParseChildren(child);
+
+        CloseGroup();
+        CloseGroup();
+    }
+    else if (elementTag == ElementTag::kStyle ||
+             elementTag == ElementTag::kLinearGradient ||
+             elementTag == ElementTag::kRadialGradient ||
+             elementTag == ElementTag::kClipPath)
+    {
+        if (!mIsLazy)
+            ParseResource(child);
+    }
+}
+
+static bool IsSamePaint(const PaintImpl& a, const PaintImpl& b)
+{
+    if (a.which() != b.which())
+        return false;
+    if (a.type() == typeid(std::shared_ptr<const GradientImpl>))
+        return boost::get<std::shared_ptr<const GradientImpl>>(a) == boost::get<std::shared_ptr<const GradientImpl>>(b);
+    if (a.type() == typeid(Variable))
+        return boost::get<Variable>(a) == boost::get<Variable>(b);
+    if (a.type() == typeid(Color))
+        return boost::get<Color>(a) == boost::get<Color>(b);
+    return boost::get<ColorKeys>(a) == boost::get<ColorKeys>(b);
+}
+
+bool StyleEqual::operator()(const FillStyleImpl& a, const FillStyleImpl& b) const
+{
+    return a.hasFill == b.hasFill && a.fillRule == b.fillRule && a.fillOpacity == b.fillOpacity && a.visibility == b.visibility
+        && a.clipRule == b.clipRule && a.color == b.color && IsSamePaint(a.internalPaint, b.internalPaint);
+}
+
+bool StyleEqual::operator()(const StrokeStyleImpl& a, const StrokeStyleImpl& b) const
+{
+    return a.hasStroke == b.hasStroke && a.strokeOpacity == b.strokeOpacity && a.lineWidth == b.lineWidth && a.lineCap == b.lineCap
+        && a.lineJoin == b.lineJoin && a.miterLimit == b.miterLimit && a.dashArray == b.dashArray && a.dashOffset == b.dashOffset
+        && IsSamePaint(a.internalPaint, b.internalPaint);
+}
+
+bool StyleEqual::operator()(const GraphicStyleImpl& a, const GraphicStyleImpl& b) const
+{
+    return a.opacity == b.opacity && a.transform == b.transform && a.clippingPath == b.clippingPath && a.display == b.display
+        && a.stopOpacity == b.stopOpacity && a.stopColor == b.stopColor;
+}
+
+bool StyleEqual::operator()(const std::set<std::string>& a, const std::set<std::string>& b) const
+{
+    return a == b;
+}
+
+static void HashCombine(size_t& hash, size_t value)
+{
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+static void HashCombine(size_t& hash, float value)
+{
+    // Equal values must hash the same. Adding 0 turns -0 into 0.
+    HashCombine(hash, std::hash<float>()(value + 0.0f));
+}
+
+static void HashCombine(size_t& hash, const Color& color)
+{
+    for (auto component : color)
+        HashCombine(hash, component);
+}
+
+static size_t HashColorImpl(const ColorImpl& color)
+{
+    size_t hash = static_cast<size_t>(color.which());
+    if (color.type() == typeid(Color))
+        HashCombine(hash, boost::get<Color>(color));
+    else if (color.type() == typeid(Variable))
+    {
+        const auto& var = boost::get<Variable>(color);
+        HashCombine(hash, std::hash<std::string>()(var.name));
+        HashCombine(hash, var.fallback);
+    }
+    return hash;
+}
+
+static size_t HashPaintImpl(const PaintImpl& paint)
+{
+    size_t hash = static_cast<size_t>(paint.which());
+    if (paint.type() == typeid(Color))
+        HashCombine(hash, boost::get<Color>(paint));
+    else if (paint.type() == typeid(std::shared_ptr<const GradientImpl>))
+        HashCombine(hash, std::hash<const GradientImpl*>()(boost::get<std::shared_ptr<const GradientImpl>>(paint).get()));
+    else if (paint.type() == typeid(Variable))
+    {
+        const auto& var = boost::get<Variable>(paint);
+        HashCombine(hash, std::hash<std::string>()(var.name));
+        HashCombine(hash, var.fallback);
+    }
+    return hash;
+}
+
+size_t StyleHash::operator()(const FillStyleImpl& fillStyle) const
+{
+    size_t hash = HashPaintImpl(fillStyle.internalPaint);
+    HashCombine(hash, static_cast<size_t>(fillStyle.hasFill));
+    HashCombine(hash, static_cast<size_t>(fillStyle.fillRule));
+    HashCombine(hash, fillStyle.fillOpacity);
+    HashCombine(hash, static_cast<size_t>(fillStyle.visibility));
+    HashCombine(hash, static_cast<size_t>(fillStyle.clipRule));
+    HashCombine(hash, HashColorImpl(fillStyle.color));
+    return hash;
+}
+
+size_t StyleHash::operator()(const StrokeStyleImpl& strokeStyle) const
+{
+    size_t hash = HashPaintImpl(strokeStyle.internalPaint);
+    HashCombine(hash, static_cast<size_t>(strokeStyle.hasStroke));
+    HashCombine(hash, strokeStyle.strokeOpacity);
+    HashCombine(hash, strokeStyle.lineWidth);
+    HashCombine(hash, static_cast<size_t>(strokeStyle.lineCap));
+    HashCombine(hash, static_cast<size_t>(strokeStyle.lineJoin));
+    HashCombine(hash, strokeStyle.miterLimit);
+    HashCombine(hash, strokeStyle.dashOffset);
+    for (auto dash : strokeStyle.dashArray)
+        HashCombine(hash, dash);
+    return hash;
+}
+
+size_t StyleHash::operator()(const GraphicStyleImpl& graphicStyle) const
+{
+    size_t hash = HashColorImpl(graphicStyle.stopColor);
+    HashCombine(hash, graphicStyle.opacity);
+    HashCombine(hash, std::hash<const Transform*>()(graphicStyle.transform.get()));
+    HashCombine(hash, std::hash<const ClippingPath*>()(graphicStyle.clippingPath.get()));
+    HashCombine(hash, static_cast<size_t>(graphicStyle.display));
+    HashCombine(hash, graphicStyle.stopOpacity);
+    return hash;
+}
+
+size_t StyleHash::operator()(const std::set<std::string>& classNames) const
+{
+    size_t hash = classNames.size();
+    for (const auto& className : classNames)
+        HashCombine(hash, std::hash<std::string>()(className));
+    return hash;
+}
+
+std::uint32_t SVGDocumentImpl::ParseUseContent(
+    XMLNode* node, StyleIndex fillStyle, StyleIndex strokeStyle, size_t useDepth)
+{
+    SVG_ASSERT(node != nullptr);
+
+    // The parsed content only depends on the inherited properties. Relative lengths
+    // depend on the viewBox which <symbol> may change. Sharing it must not bypass the
+    // limits, so every instantiation costs as much as parsing the content again.
+    for (const auto& useContent : mUseContents[node])
+    {
+        if (useContent.viewBox == mViewBox && useContent.fillStyle == fillStyle && useContent.strokeStyle == strokeStyle)
         {
-            std::vector<float> numberList;
-            if (SVGStringParser::ParseListOfNumbers(std::string(attr->value()), numberList) && numberList.size() == 4)
-                graphicStyle.transform = mRenderer->CreateTransform(1, 0, 0, 1, -numberList[0], -numberList[1]);
-            {
-                mViewBox = {{numberList[0], numberList[1], numberList[2], numberList[3]}};
-            }
+            mBudget.AddReusedContent(useContent.elementCount, useContent.useCount, useDepth + useContent.useDepth);
+            return useContent.content;
         }
+    }
 
-        auto group = std::make_shared<Group>(graphicStyle, classNames);
-        mGroupStack.push(group);
-        AddChildToCurrentGroup(group, std::move(idString));
+    auto viewBox = mViewBox;
+    auto elementCount = mBudget.ElementCount();
+    auto useCount = mBudget.UseCount();
+    auto outerUseDepth = mBudget.UseDepth();
+    mBudget.SetUseDepth(useDepth);
+    mFillStyleStack.push(fillStyle);
+    mStrokeStyleStack.push(strokeStyle);
+    auto content = OpenTree();
+    mUseTargets.push_back(node);
+
+    if (node->first_node() == 0)
+        ParseChild(node);
+    else
+        ParseChildren(node);
 
-        ParseChildren(child);
+    mUseTargets.pop_back();
+    CloseGroup();
+    mFillStyleStack.pop();
+    mStrokeStyleStack.pop();
 
-        mGroupStack.pop();
-    }
-    else if (elementName == "style" ||
-             elementName == "linearGradient" ||
-             elementName == "radialGradient" ||
-             elementName == "clipPath")
-        ParseResource(child);
+    auto nestedUseDepth = mBudget.UseDepth() - useDepth;
+    mBudget.SetUseDepth(std::max(outerUseDepth, mBudget.UseDepth()));
+
+    // Nested <use> elements may have added entries meanwhile.
+    mUseContents[node].push_back({fillStyle, strokeStyle, viewBox, content,
+        mBudget.ElementCount() - elementCount, mBudget.UseCount() - useCount, nestedUseDepth});
+    return content;
 }
 
 void SVGDocumentImpl::ParseResources(XMLNode* node)
@@ -413,8 +1095,8 @@ void SVGDocumentImpl::ParseResource(XMLNode* child)
     std::set<std::string> classNames;
     auto graphicStyle = ParseGraphic(child, fillStyle, strokeStyle, classNames);
 
-    std::string elementName = child->name();
-    if (elementName == "linearGradient" || elementName == "radialGradient")
+    auto elementTag = GetElementTag(child->name(), child->name_size());
+    if (elementTag == ElementTag::kLinearGradient || elementTag == ElementTag::kRadialGradient)
     {
         mFillStyleStack.push(fillStyle);
         mStrokeStyleStack.push(strokeStyle);
@@ -424,64 +1106,237 @@ void SVGDocumentImpl::ParseResource(XMLNode* child)
         mFillStyleStack.pop();
         mStrokeStyleStack.pop();
     }
-    else if (elementName == "style")
+    else if (elementTag == ElementTag::kStyle)
         ParseStyle(child);
-    else if (elementName == "clipPath")
+    else if (elementTag == ElementTag::kClipPath)
+    {
+        auto id = child->first_attribute("id");
+        if (!id)
+            return;
+
+        mFillStyleStack.push(fillStyle);
+        mStrokeStyleStack.push(strokeStyle);
+
+        // SVG only allows shapes (and <use> elements referencing shapes) as children of
+        // <clipPath>. Ignore all other elements.
+        bool hasClipContent{false};
+        for (auto clipPathChild = child->first_node(); clipPathChild != nullptr; clipPathChild = clipPathChild->next_sibling())
+        {
+            // WebKit and Blink allow the clipping path if there is at least one valid basic shape child.
+            if (auto path = ParseShape(clipPathChild, GetElementTag(clipPathChild->name(), clipPathChild->name_size())))
+            {
+                std::unique_ptr<Transform> transform;
+                if (auto transformAttr = clipPathChild->first_attribute("transform"))
+                {
+                    transform = ParseTransform(transformAttr->value(), transformAttr->value_size());
+                }
+                auto fillStyleChild = mFillStyleStack.top();
+                auto strokeStyleChild = mStrokeStyleStack.top();
+                std::set<std::string> classNames;
+                ParseGraphic(child, fillStyleChild, strokeStyleChild, classNames);
+                mClippingPaths[std::string(id->value(), id->value_size())] = std::make_shared<ClippingPath>(true, mFillStyles[fillStyleChild].clipRule, std::move(path), std::move(transform));
+                hasClipContent = true;
+                break;
+            }
+        }
+        if (!hasClipContent)
+            mClippingPaths[std::string(id->value(), id->value_size())] = std::make_shared<ClippingPath>(false, WindingRule::kNonZero, nullptr, nullptr);
+        mFillStyleStack.pop();
+        mStrokeStyleStack.pop();
+    }
+    else
     {
         auto id = child->first_attribute("id");
         if (!id)
             return;
 
-        mFillStyleStack.push(fillStyle);
-        mStrokeStyleStack.push(strokeStyle);
+        mResourceIDs[std::string(id->value(), id->value_size())] = child;
+        mHasNewResource = true;
+    }
+}
+
+// Returns the attribute with the outline of a <path>, <polygon> or <polyline> element.
+static XMLAttribute* GetPathDataAttr(XMLNode* node, ElementTag elementTag)
+{
+    return node->first_attribute(elementTag == ElementTag::kPath ? "d" : "points");
+}
+
+// Adds the outline of a <path>, <polygon> or <polyline> element to path. Does not
+// touch any state of the document and may run on any thread.
+static void ParsePathData(const XMLAttribute* attr, ElementTag elementTag, Path& path)
+{
+    if (elementTag == ElementTag::kPath)
+    {
+        SVGStringParser::ParsePathString(attr->value(), attr->value_size(), path);
+        return;
+    }
+
+    // This does not follow the spec which requires at least one space or comma between
+    // coordinate pairs. However, Blink and WebKit do it the same way.
+    SVGStringParser::ParsePoints(attr->value(), attr->value_size(), elementTag == ElementTag::kPolygon, path);
+}
+
+// Same as above but also counts the segments against the budget.
+static void ParsePathData(const XMLAttribute* attr, ElementTag elementTag, Path& path, ParseBudget& budget)
+{
+    if (!budget.LimitsPaths())
+    {
+        ParsePathData(attr, elementTag, path);
+        return;
+    }
+
+    BudgetedPath budgetedPath(path, budget);
+    ParsePathData(attr, elementTag, budgetedPath);
+    budgetedPath.Finish();
+}
+
+void SVGDocumentImpl::PreparsePaths(XMLNode* rootNode)
+{
+    SVG_ASSERT(rootNode != nullptr);
+
+    size_t threadCount = mOptions.pathThreadCount;
+    if (threadCount < 2)
+        return;
+
+    // Collect the outlines of all elements in document order. Elements that the
+    // traversal never reaches are parsed needlessly but do no harm.
+    std::vector<std::pair<const XMLAttribute*, ElementTag>> pathData;
+    auto node = rootNode->first_node();
+    while (node)
+    {
+        auto elementTag = GetElementTag(node->name(), node->name_size());
+        if (elementTag == ElementTag::kPath || elementTag == ElementTag::kPolygon || elementTag == ElementTag::kPolyline)
+        {
+            if (auto attr = GetPathDataAttr(node, elementTag))
+            {
+                mPreparsedPathIndex[node] = pathData.size();
+                pathData.emplace_back(attr, elementTag);
+            }
+        }
+
+        if (node->first_node())
+        {
+            node = node->first_node();
+            continue;
+        }
+        while (node != rootNode && !node->next_sibling())
+            node = node->parent();
+        node = node != rootNode ? node->next_sibling() : nullptr;
+    }
+    if (pathData.empty())
+        return;
+
+    // Workers grab small batches of elements so that a few long outlines do not
+    // stall a single thread. Every recording is written by exactly one worker.
+    constexpr size_t kBatchSize = 32;
+    mPreparsedPaths.resize(pathData.size());
+    threadCount = std::min(threadCount, (pathData.size() + kBatchSize - 1) / kBatchSize);
+    std::atomic<size_t> nextIndex{0};
+    std::vector<std::exception_ptr> errors(threadCount);
+    auto worker = [&](size_t workerIndex) {
+        try
+        {
+            for (;;)
+            {
+                auto first = nextIndex.fetch_add(kBatchSize);
+                if (first >= pathData.size())
+                    break;
+                auto last = std::min(first + kBatchSize, pathData.size());
+                for (auto i = first; i < last; ++i)
+                    ParsePathData(pathData[i].first, pathData[i].second, mPreparsedPaths[i], mBudget);
+            }
+        }
+        catch (...)
+        {
+            errors[workerIndex] = std::current_exception();
+            // Let the other workers stop after their current batch.
+            nextIndex = pathData.size();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t i = 1; i < threadCount; ++i)
+    {
+        try
+        {
+            threads.emplace_back(worker, i);
+        }
+        catch (...)
+        {
+            // Continue with the threads that could get started.
+            break;
+        }
+    }
+    worker(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+std::shared_ptr<Path> SVGDocumentImpl::ParseShape(XMLNode* child, ElementTag elementTag)
+{
+    SVG_ASSERT(child != nullptr);
+
+    if (!mOptions.deduplicatePaths && !RecordsGeometry())
+    {
+        std::shared_ptr<Path> path = mRenderer->CreatePath();
+        if (!ParseOutline(child, elementTag, *path))
+            return nullptr;
+        return path;
+    }
+
+    auto preparsed = mPreparsedPathIndex.find(child);
+    if (preparsed != mPreparsedPathIndex.end())
+    {
+        const auto& outline = mPreparsedPaths[preparsed->second];
+        return mOptions.deduplicatePaths ? SharePath(outline) : CreatePath(outline);
+    }
+
+    PathRecorder recorder;
+    if (!ParseOutline(child, elementTag, recorder))
+        return nullptr;
+    return mOptions.deduplicatePaths ? SharePath(recorder) : CreatePath(recorder);
+}
+
+std::shared_ptr<Path> SVGDocumentImpl::CreatePath(const PathRecorder& outline)
+{
+    std::shared_ptr<Path> path = mRenderer->CreatePath();
+    outline.Replay(*path);
+    if (mOptions.isSerializable)
+        mPathRecordings[path.get()] = outline;
+    if (mOptions.computeBounds)
+        RecordPathBounds(*path, outline);
+    return path;
+}
 
-        // SVG only allows shapes (and <use> elements referencing shapes) as children of
-        // <clipPath>. Ignore all other elements.
-        bool hasClipContent{false};
-        for (auto clipPathChild = child->first_node(); clipPathChild != nullptr; clipPathChild = clipPathChild->next_sibling())
+std::shared_ptr<Path> SVGDocumentImpl::SharePath(const PathRecorder& outline)
+{
+    auto& candidates = mSharedPaths[outline.Hash()];
+    for (const auto& candidate : candidates)
+    {
+        if (candidate.first == outline)
         {
-            // WebKit and Blink allow the clipping path if there is at least one valid basic shape child.
-            if (auto path = ParseShape(clipPathChild))
-            {
-                std::unique_ptr<Transform> transform;
-                if (auto transformAttr = clipPathChild->first_attribute("transform"))
-                {
-                    auto transformHandler = [&]() {
-                        SVG_ASSERT(mRenderer != nullptr);
-                        return mRenderer->CreateTransform();
-                    };
-                    transform = SVGStringParser::ParseTransform(transformAttr->value(), transformHandler);
-                }
-                auto fillStyleChild = mFillStyleStack.top();
-                auto strokeStyleChild = mStrokeStyleStack.top();
-                std::set<std::string> classNames;
-                ParseGraphic(child, fillStyleChild, strokeStyleChild, classNames);
-                mClippingPaths[id->value()] = std::make_shared<ClippingPath>(true, fillStyleChild.clipRule, std::move(path), std::move(transform));
-                hasClipContent = true;
-                break;
-            }
+            ++mDeduplicatedPathCount;
+            return candidate.second;
         }
-        if (!hasClipContent)
-            mClippingPaths[id->value()] = std::make_shared<ClippingPath>(false, WindingRule::kNonZero, nullptr, nullptr);
-        mFillStyleStack.pop();
-        mStrokeStyleStack.pop();
     }
-    else
-    {
-        auto id = child->first_attribute("id");
-        if (!id)
-            return;
 
-        mResourceIDs[id->value()] = child;
-    }
+    auto path = CreatePath(outline);
+    candidates.emplace_back(outline, path);
+    return path;
 }
 
-std::unique_ptr<Path> SVGDocumentImpl::ParseShape(XMLNode* child)
+bool SVGDocumentImpl::ParseOutline(XMLNode* child, ElementTag elementTag, Path& path)
 {
     SVG_ASSERT(child != nullptr);
 
-    std::string elementName = child->name();
-    if (elementName == "rect")
+    if (elementTag == ElementTag::kRect)
     {
         float x = ParseLengthFromAttr(child, "x", LengthType::kHorizontal);
         float y = ParseLengthFromAttr(child, "y", LengthType::kVertical);
@@ -491,7 +1346,7 @@ std::unique_ptr<Path> SVGDocumentImpl::ParseShape(XMLNode* child)
 
         // SVG requires to disable rendering if width or height are 0.
         if (isCloseToZero(width) || isCloseToZero(height))
-            return nullptr;
+            return false;
 
         bool hasRx = HasAttr(child, "rx");
         bool hasRy = HasAttr(child, "ry");
@@ -526,22 +1381,21 @@ std::unique_ptr<Path> SVGDocumentImpl::ParseShape(XMLNode* child)
         rx = std::min(rx, width / 2.0f);
         ry = std::min(ry, height / 2.0f);
 
-        auto path = mRenderer->CreatePath();
         if (isCloseToZero(rx) || isCloseToZero(ry))
         {
-            path->Rect(x, y, width, height);
+            path.Rect(x, y, width, height);
         }
         else
         {
-            path->RoundedRect(x, y, width, height, rx, ry);
+            path.RoundedRect(x, y, width, height, rx, ry);
         }
-        return path;
+        return true;
     }
-    else if (elementName == "ellipse" || elementName == "circle")
+    else if (elementTag == ElementTag::kEllipse || elementTag == ElementTag::kCircle)
     {
         float rx{}, ry{};
 
-        if (elementName == "ellipse")
+        if (elementTag == ElementTag::kEllipse)
         {
             rx = ParseLengthFromAttr(child, "rx", LengthType::kHorizontal);
             ry = ParseLengthFromAttr(child, "ry", LengthType::kVertical);
@@ -554,192 +1408,193 @@ std::unique_ptr<Path> SVGDocumentImpl::ParseShape(XMLNode* child)
 
         // SVG requires to disable rendering if rx or ry are 0.
         if (isCloseToZero(rx) || isCloseToZero(ry))
-            return nullptr;
+            return false;
 
         float cx = ParseLengthFromAttr(child, "cx", LengthType::kHorizontal);
         float cy = ParseLengthFromAttr(child, "cy", LengthType::kVertical);
 
-        auto path = mRenderer->CreatePath();
-        path->Ellipse(cx, cy, rx, ry);
-
-        return path;
-    }
-    else if (elementName == "polygon" || elementName == "polyline")
-    {
-        auto attr = child->first_attribute("points");
-        if (!attr)
-            return nullptr;
-        // This does not follow the spec which requires at least one space or comma between
-        // coordinate pairs. However, Blink and WebKit do it the same way.
-        std::vector<float> numberList;
-        SVGStringParser::ParseListOfNumbers(attr->value(), numberList);
-        size_t size = numberList.size();
-        auto path = mRenderer->CreatePath();
-        if (size > 1)
-        {
-            if (size % 2 == 1)
-                --size;
-            size_t i{};
-            path->MoveTo(numberList[i], numberList[i + 1]);
-            i += 2;
-            for (; i < size; i += 2)
-                path->LineTo(numberList[i], numberList[i + 1]);
-            if (elementName == "polygon")
-                path->ClosePath();
-        }
+        path.Ellipse(cx, cy, rx, ry);
 
-        return path;
+        return true;
     }
-    else if (elementName == "path")
+    else if (elementTag == ElementTag::kPolygon || elementTag == ElementTag::kPolyline || elementTag == ElementTag::kPath)
     {
-        auto attr = child->first_attribute("d");
+        auto attr = GetPathDataAttr(child, elementTag);
         if (!attr)
-            return nullptr;
+            return false;
 
-        auto path = mRenderer->CreatePath();
-        SVGStringParser::ParsePathString(attr->value(), *path);
+        auto preparsed = mPreparsedPathIndex.find(child);
+        if (preparsed != mPreparsedPathIndex.end())
+            mPreparsedPaths[preparsed->second].Replay(path);
+        else
+            ParsePathData(attr, elementTag, path, mBudget);
 
-        return path;
+        return true;
     }
-    else if (elementName == "line")
+    else if (elementTag == ElementTag::kLine)
     {
-        auto path = mRenderer->CreatePath();
-        path->MoveTo(ParseLengthFromAttr(child, "x1", LengthType::kHorizontal), ParseLengthFromAttr(child, "y1", LengthType::kVertical));
-        path->LineTo(ParseLengthFromAttr(child, "x2", LengthType::kHorizontal), ParseLengthFromAttr(child, "y2", LengthType::kVertical));
+        path.MoveTo(ParseLengthFromAttr(child, "x1", LengthType::kHorizontal), ParseLengthFromAttr(child, "y1", LengthType::kVertical));
+        path.LineTo(ParseLengthFromAttr(child, "x2", LengthType::kHorizontal), ParseLengthFromAttr(child, "y2", LengthType::kVertical));
 
-        return path;
+        return true;
     }
-    return nullptr;
+    return false;
 }
 
 GraphicStyleImpl SVGDocumentImpl::ParseGraphic(
-    XMLNode* node, FillStyleImpl& fillStyle, StrokeStyleImpl& strokeStyle, std::set<std::string>& classNames)
+    XMLNode* node, StyleIndex& fillStyle, StyleIndex& strokeStyle, std::set<std::string>& classNames)
 {
     SVG_ASSERT(node != nullptr);
 
+    PropertySlots attributes{};
+    ParsePresentationAttributes(node, attributes);
+
     std::vector<PropertySet> propertySets;
-    propertySets.push_back(ParsePresentationAttributes(node));
     ParseStyleAttr(node, propertySets, classNames);
 
+    // The inherited styles only get copied if the node overrides any of their properties.
     GraphicStyleImpl graphicStyle{};
+    FillStyleImpl newFillStyle;
+    StrokeStyleImpl newStrokeStyle;
+    bool hasFillProperties{};
+    bool hasStrokeProperties{};
+    auto parseProperties = [&](const PropertySlots& properties) {
+        ParseGraphicsProperties(graphicStyle, properties);
+        if (HasProperty(properties, PropertyTag::kColor, PropertyTag::kVisibility))
+        {
+            if (!hasFillProperties)
+                newFillStyle = mFillStyles[fillStyle];
+            hasFillProperties = true;
+            ParseFillProperties(newFillStyle, properties);
+        }
+        if (HasProperty(properties, PropertyTag::kStroke, PropertyTag::kStrokeWidth))
+        {
+            if (!hasStrokeProperties)
+                newStrokeStyle = mStrokeStyles[strokeStyle];
+            hasStrokeProperties = true;
+            ParseStrokeProperties(newStrokeStyle, properties);
+        }
+    };
+
+    parseProperties(attributes);
     for (const auto& propertySet : propertySets)
+        parseProperties(ClassifyProperties(propertySet));
+
+    AssignSlot(graphicStyle.stopColor);
+    if (hasFillProperties)
     {
-        ParseGraphicsProperties(graphicStyle, propertySet);
-        ParseFillProperties(fillStyle, propertySet);
-        ParseStrokeProperties(strokeStyle, propertySet);
+        AssignSlot(newFillStyle.internalPaint);
+        AssignSlot(newFillStyle.color);
+        PreResolvePaint(newFillStyle);
+        fillStyle = mFillStyles.Intern(newFillStyle);
     }
-
-    auto attr = node->first_attribute("transform");
-    if (attr)
+    if (hasStrokeProperties)
     {
-        auto transformHandler = [&]() {
-            SVG_ASSERT(mRenderer != nullptr);
-            return mRenderer->CreateTransform();
-        };
-        graphicStyle.transform = SVGStringParser::ParseTransform(attr->value(), transformHandler);
+        AssignSlot(newStrokeStyle.internalPaint);
+        PreResolvePaint(newStrokeStyle);
+        strokeStyle = mStrokeStyles.Intern(newStrokeStyle);
     }
 
+    const auto& transform = GetProperty(attributes, PropertyTag::kTransform);
+    if (transform.value)
+        graphicStyle.transform = ParseTransform(transform.value, transform.length);
+
     return graphicStyle;
 }
 
-PropertySet SVGDocumentImpl::ParsePresentationAttributes(XMLNode* node)
+void SVGDocumentImpl::ParsePresentationAttributes(XMLNode* node, PropertySlots& properties)
 {
     SVG_ASSERT(node != nullptr);
 
-    PropertySet propertySet;
-    auto attributeHandler = [&](const std::string& propertyName) {
-        auto attr = node->first_attribute(propertyName.c_str());
-        if (attr)
-            propertySet.insert({propertyName, attr->value()});
-    };
-    for (const auto& propertyName : gInheritedPropertyNames)
-        attributeHandler(propertyName);
-    for (const auto& propertyName : gNonInheritedPropertyNames)
-        attributeHandler(propertyName);
-    return propertySet;
+    // Walk the attributes once. The first occurrence of a property wins.
+    for (auto attr = node->first_attribute(); attr; attr = attr->next_attribute())
+        SetProperty(properties, attr->name(), attr->name_size(), attr->value(), attr->value_size());
+}
+
+PropertySlots SVGDocumentImpl::ClassifyProperties(const PropertySet& propertySet)
+{
+    PropertySlots properties{};
+    for (const auto& property : propertySet)
+        SetProperty(properties, property.first.data(), property.first.size(), property.second.data(), property.second.size());
+    return properties;
 }
 
-void SVGDocumentImpl::ParseFillProperties(FillStyleImpl& fillStyle, const PropertySet& propertySet)
+void SVGDocumentImpl::ParseFillProperties(FillStyleImpl& fillStyle, const PropertySlots& properties)
 {
-    auto prop = propertySet.find("fill");
-    auto iterEnd = propertySet.end();
-    if (prop != iterEnd)
+    auto prop = &GetProperty(properties, PropertyTag::kFill);
+    if (prop->value)
     {
-        auto result = SVGStringParser::ParsePaint(prop->second.c_str(), mGradients, mViewBox, fillStyle.internalPaint);
+        auto result = SVGStringParser::ParsePaint(prop->value, prop->length, mGradientPaints, fillStyle.internalPaint);
         if (result == SVGDocumentImpl::Result::kDisabled)
             fillStyle.hasFill = false;
         else if (result == SVGDocumentImpl::Result::kSuccess)
             fillStyle.hasFill = true;
     }
 
-    prop = propertySet.find("fill-opacity");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kFillOpacity);
+    if (prop->value)
     {
         float opacity{};
-        if (SVGStringParser::ParseNumber(prop->second.c_str(), opacity))
+        if (SVGStringParser::ParseNumber(prop->value, prop->length, opacity))
             fillStyle.fillOpacity = std::max<float>(0.0, std::min<float>(1.0, opacity));
     }
 
-    prop = propertySet.find("fill-rule");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kFillRule);
+    if (prop->value)
     {
-        auto fillRuleString = std::string(prop->second.c_str());
-        if (fillRuleString == "evenodd")
+        if (IsValue(*prop, "evenodd"))
             fillStyle.fillRule = WindingRule::kEvenOdd;
-        else if (fillRuleString == "nonzero")
+        else if (IsValue(*prop, "nonzero"))
             fillStyle.fillRule = WindingRule::kNonZero;
     }
 
     // Other inherited properties
-    prop = propertySet.find("color");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kColor);
+    if (prop->value)
     {
         ColorImpl color = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
-        auto result = SVGStringParser::ParseColor(prop->second.c_str(), color, false);
+        auto result = SVGStringParser::ParseColor(prop->value, prop->length, color, false);
         if (result == SVGDocumentImpl::Result::kSuccess)
             fillStyle.color = color;
     }
 
-    prop = propertySet.find("visibility");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kVisibility);
+    if (prop->value)
     {
-        auto visibilityString = std::string(prop->second.c_str());
-        if (visibilityString == "hidden")
+        if (IsValue(*prop, "hidden"))
             fillStyle.visibility = false;
-        else if (visibilityString == "collapse" || visibilityString == "visible")
+        else if (IsValue(*prop, "collapse") || IsValue(*prop, "visible"))
             fillStyle.visibility = true;
     }
 
-    prop = propertySet.find("clip-rule");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kClipRule);
+    if (prop->value)
     {
-        if (std::string(prop->second.c_str()) == "evenodd")
+        if (IsValue(*prop, "evenodd"))
             fillStyle.clipRule = WindingRule::kEvenOdd;
-        else if (std::string(prop->second.c_str()) == "nonzero")
+        else if (IsValue(*prop, "nonzero"))
             fillStyle.clipRule = WindingRule::kNonZero;
     }
 }
 
-void SVGDocumentImpl::ParseStrokeProperties(StrokeStyleImpl& strokeStyle, const PropertySet& propertySet)
+void SVGDocumentImpl::ParseStrokeProperties(StrokeStyleImpl& strokeStyle, const PropertySlots& properties)
 {
-    auto prop = propertySet.find("stroke");
-    auto iterEnd = propertySet.end();
-    if (prop != iterEnd)
+    auto prop = &GetProperty(properties, PropertyTag::kStroke);
+    if (prop->value)
     {
-        std::string strokeValue = prop->second;
-        auto result = SVGStringParser::ParsePaint(strokeValue.c_str(), mGradients, mViewBox, strokeStyle.internalPaint);
+        auto result = SVGStringParser::ParsePaint(prop->value, prop->length, mGradientPaints, strokeStyle.internalPaint);
         if (result == SVGDocumentImpl::Result::kDisabled)
             strokeStyle.hasStroke = false;
         else if (result == SVGDocumentImpl::Result::kSuccess)
             strokeStyle.hasStroke = true;
     }
 
-    prop = propertySet.find("stroke-width");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStrokeWidth);
+    if (prop->value)
     {
         float strokeWidth{};
         // Ignore stroke-width if invalid or negative.
-        if (SVGStringParser::ParseLengthOrPercentage(prop->second, RelativeLength(LengthType::kDiagonal), strokeWidth, true)
+        if (SVGStringParser::ParseLengthOrPercentage(prop->value, prop->length, RelativeLength(LengthType::kDiagonal), strokeWidth, true)
             && strokeWidth >= 0)
             strokeStyle.lineWidth = strokeWidth;
         // Disable stroke on a stroke-width of 0.
@@ -747,46 +1602,46 @@ void SVGDocumentImpl::ParseStrokeProperties(StrokeStyleImpl& strokeStyle, const
             strokeStyle.hasStroke = false;
     }
 
-    prop = propertySet.find("stroke-linecap");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStrokeLinecap);
+    if (prop->value)
     {
-        if (prop->second == "round")
+        if (IsValue(*prop, "round"))
             strokeStyle.lineCap = LineCap::kRound;
-        else if (prop->second == "square")
+        else if (IsValue(*prop, "square"))
             strokeStyle.lineCap = LineCap::kSquare;
     }
 
-    prop = propertySet.find("stroke-linejoin");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStrokeLinejoin);
+    if (prop->value)
     {
-        if (prop->second == "round")
+        if (IsValue(*prop, "round"))
             strokeStyle.lineJoin = LineJoin::kRound;
-        else if (prop->second == "bevel")
+        else if (IsValue(*prop, "bevel"))
             strokeStyle.lineJoin = LineJoin::kBevel;
     }
 
-    prop = propertySet.find("stroke-miterlimit");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStrokeMiterlimit);
+    if (prop->value)
     {
         float miter{};
         // Miter must be bigger 1. Otherwise ignore.
-        if (SVGStringParser::ParseNumber(prop->second.c_str(), miter) && miter >= 1)
+        if (SVGStringParser::ParseNumber(prop->value, prop->length, miter) && miter >= 1)
             strokeStyle.miterLimit = miter;
     }
 
-    prop = propertySet.find("stroke-dashoffset");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStrokeDashoffset);
+    if (prop->value)
     {
         float strokeDashoffset{};
-        if (SVGStringParser::ParseLengthOrPercentage(prop->second, RelativeLength(LengthType::kDiagonal), strokeDashoffset, true))
+        if (SVGStringParser::ParseLengthOrPercentage(prop->value, prop->length, RelativeLength(LengthType::kDiagonal), strokeDashoffset, true))
             strokeStyle.dashOffset = strokeDashoffset;
     }
 
-    prop = propertySet.find("stroke-dasharray");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStrokeDasharray);
+    if (prop->value)
     {
         float diagonal = sqrtf(mViewBox[2] * mViewBox[2] + mViewBox[3] * mViewBox[3]);
-        if (!SVGStringParser::ParseListOfLengthOrPercentage(prop->second.c_str(), diagonal, strokeStyle.dashArray, true))
+        if (!SVGStringParser::ParseListOfLengthOrPercentage(prop->value, prop->length, diagonal, strokeStyle.dashArray, true))
             strokeStyle.dashArray.clear();
         for (auto it = strokeStyle.dashArray.begin(); it < strokeStyle.dashArray.end(); ++it)
         {
@@ -807,59 +1662,57 @@ void SVGDocumentImpl::ParseStrokeProperties(StrokeStyleImpl& strokeStyle, const
         }
     }
 
-    prop = propertySet.find("stroke-opacity");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStrokeOpacity);
+    if (prop->value)
     {
         float opacity{};
-        if (SVGStringParser::ParseNumber(prop->second.c_str(), opacity))
+        if (SVGStringParser::ParseNumber(prop->value, prop->length, opacity))
             strokeStyle.strokeOpacity = std::max<float>(0.0, std::min<float>(1.0, opacity));
     }
 }
 
-void SVGDocumentImpl::ParseGraphicsProperties(GraphicStyleImpl& graphicStyle, const PropertySet& propertySet)
+void SVGDocumentImpl::ParseGraphicsProperties(GraphicStyleImpl& graphicStyle, const PropertySlots& properties)
 {
-    auto prop = propertySet.find("opacity");
-    auto iterEnd = propertySet.end();
-    if (prop != iterEnd)
+    auto prop = &GetProperty(properties, PropertyTag::kOpacity);
+    if (prop->value)
     {
         float opacity{};
-        if (SVGStringParser::ParseNumber(prop->second.c_str(), opacity))
+        if (SVGStringParser::ParseNumber(prop->value, prop->length, opacity))
             graphicStyle.opacity = std::max<float>(0.0, std::min<float>(1.0, opacity));
     }
 
-    prop = propertySet.find("clip-path");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kClipPath);
+    if (prop->value)
     {
         // FIXME: Use proper parser.
         auto urlLength = strlen("url(#");
-        std::string id = prop->second;
+        std::string id{prop->value, prop->length};
         id = id.substr(urlLength, id.size() - urlLength - 1);
         auto clippingPathIt = mClippingPaths.find(id);
         if (clippingPathIt != mClippingPaths.end())
             graphicStyle.clippingPath = clippingPathIt->second;
     }
 
-    prop = propertySet.find("display");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kDisplay);
+    if (prop->value)
     {
-        std::string displayString = prop->second;
-        if (displayString.compare("none"))
+        if (!IsValue(*prop, "none"))
             graphicStyle.display = false;
     }
 
-    prop = propertySet.find("stop-opacity");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStopOpacity);
+    if (prop->value)
     {
         float opacity{};
-        if (SVGStringParser::ParseNumber(prop->second.c_str(), opacity))
+        if (SVGStringParser::ParseNumber(prop->value, prop->length, opacity))
             graphicStyle.stopOpacity = std::max<float>(0.0, std::min<float>(1.0, opacity));
     }
 
-    prop = propertySet.find("stop-color");
-    if (prop != iterEnd)
+    prop = &GetProperty(properties, PropertyTag::kStopColor);
+    if (prop->value)
     {
         ColorImpl color = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
-        auto result = SVGStringParser::ParseColor(prop->second.c_str(), color, true);
+        auto result = SVGStringParser::ParseColor(prop->value, prop->length, color, true);
         if (result == SVGDocumentImpl::Result::kSuccess)
             graphicStyle.stopColor = color;
     }
@@ -878,7 +1731,7 @@ float SVGDocumentImpl::ParseColorStop(XMLNode* node, std::vector<ColorStopImpl>&
     // * Stops must be in the range [0.0, 1.0].
     auto attr = node->first_attribute("offset");
     float offset{};
-    offset = (attr && SVGStringParser::ParseNumber(attr->value(), offset)) ? offset : lastOffset;
+    offset = (attr && SVGStringParser::ParseNumber(attr->value(), attr->value_size(), offset)) ? offset : lastOffset;
     offset = std::max<float>(lastOffset, offset);
     offset = std::min<float>(1.0, std::max<float>(0.0, offset));
 
@@ -886,7 +1739,7 @@ float SVGDocumentImpl::ParseColorStop(XMLNode* node, std::vector<ColorStopImpl>&
     if (paint.type() == typeid(ColorKeys))
     {
         // Value is "currentColor". Simply set value to CSS color property.
-        paint = fillStyle.color;
+        paint = mFillStyles[fillStyle].color;
     }
 
     graphicStyle.stopOpacity = std::max<float>(0.0, std::min<float>(1.0, graphicStyle.stopOpacity));
@@ -907,7 +1760,7 @@ void SVGDocumentImpl::ParseColorStops(XMLNode* node, GradientImpl& gradient)
     std::vector<ColorStopImpl> colorStops;
     for (auto child = node->first_node(); child != nullptr; child = child->next_sibling())
     {
-        if (std::string(child->name()) == "stop")
+        if (GetElementTag(child->name(), child->name_size()) == ElementTag::kStop)
             lastOffset = ParseColorStop(child, colorStops, lastOffset);
     }
     // Make sure we always have stops in the range 0% and 100%.
@@ -939,7 +1792,7 @@ void SVGDocumentImpl::ParseGradient(XMLNode* node)
     auto attr = node->first_attribute("xlink:href");
     if (attr)
     {
-        std::string href{attr->value()};
+        std::string href{attr->value(), attr->value_size()};
         // href starts with a #, ignore it.
         auto it = mGradients.find(href.substr(1));
         if (it != mGradients.end())
@@ -948,10 +1801,10 @@ void SVGDocumentImpl::ParseGradient(XMLNode* node)
 
     ParseColorStops(node, gradient);
 
-    auto nodeName = std::string(node->name());
-    if (nodeName == "linearGradient")
+    auto elementTag = GetElementTag(node->name(), node->name_size());
+    if (elementTag == ElementTag::kLinearGradient)
         gradient.type = GradientType::kLinearGradient;
-    else if (nodeName == "radialGradient")
+    else if (elementTag == ElementTag::kRadialGradient)
         gradient.type = GradientType::kRadialGradient;
     else
     {
@@ -993,7 +1846,7 @@ void SVGDocumentImpl::ParseGradient(XMLNode* node)
     attr = node->first_attribute("spreadMethod");
     if (attr)
     {
-        auto spreadMethodString = std::string(attr->value());
+        auto spreadMethodString = std::string(attr->value(), attr->value_size());
         if (spreadMethodString == "pad")
             gradient.method = SpreadMethod::kPad;
         else if (spreadMethodString == "reflect")
@@ -1003,79 +1856,437 @@ void SVGDocumentImpl::ParseGradient(XMLNode* node)
     }
     attr = node->first_attribute("gradientTransform");
     if (attr)
-    {
-        auto transformHandler = [&]() {
-            SVG_ASSERT(mRenderer != nullptr);
-            return mRenderer->CreateTransform();
-        };
-        gradient.transform = SVGStringParser::ParseTransform(attr->value(), transformHandler);
-    }
+        gradient.transform = ParseTransform(attr->value(), attr->value_size());
 
     attr = node->first_attribute("id");
     if (attr)
-        mGradients.insert({attr->value(), gradient});
+    {
+        std::string id(attr->value(), attr->value_size());
+        mGradientPaints.insert({id, ResolveGradient(gradient, mViewBox)});
+        mGradients.insert({std::move(id), std::move(gradient)});
+    }
+}
+
+std::shared_ptr<const GradientImpl> SVGDocumentImpl::ResolveGradient(GradientImpl gradient, const std::array<float, 4>& viewBox)
+{
+    // Percentage values that do neither correlate to horizontal nor vertical dimensions
+    // need to be relative to the hypotenuse of both. Example: r="50%"
+    float sqr = sqrtf(viewBox[2] * viewBox[2] + viewBox[3] * viewBox[3]);
+    if (gradient.type == GradientType::kLinearGradient)
+    {
+        // https://www.w3.org/TR/SVG11/pservers.html#LinearGradients
+        gradient.x1 = std::isfinite(gradient.x1) ? gradient.x1 : 0;
+        gradient.y1 = std::isfinite(gradient.y1) ? gradient.y1 : 0;
+        gradient.x2 = std::isfinite(gradient.x2) ? gradient.x2 : viewBox[2];
+        gradient.y2 = std::isfinite(gradient.y2) ? gradient.y2 : 0;
+    }
+    else
+    {
+        // https://www.w3.org/TR/SVG11/pservers.html#RadialGradients
+        gradient.cx = std::isfinite(gradient.cx) ? gradient.cx : 0.5f * viewBox[2];
+        gradient.cy = std::isfinite(gradient.cy) ? gradient.cy : 0.5f * viewBox[3];
+        gradient.fx = std::isfinite(gradient.fx) ? gradient.fx : gradient.cx;
+        gradient.fy = std::isfinite(gradient.fy) ? gradient.fy : gradient.cy;
+        gradient.r = std::isfinite(gradient.r) ? gradient.r : 0.5f * sqr;
+    }
+    return std::make_shared<const GradientImpl>(std::move(gradient));
 }
 
-void SVGDocumentImpl::Render(const ColorMap& colorMap, float width, float height)
+void SVGDocumentImpl::ResolveGradients()
 {
-    SVG_ASSERT(mGroup);
-    if (!mGroup)
+    // Default gradient coordinates depend on the viewBox at the time a gradient gets referenced.
+    for (const auto& gradient : mGradients)
+        mGradientPaints[gradient.first] = ResolveGradient(gradient.second, mViewBox);
+}
+
+void SVGDocumentImpl::Render(const char* id, const ColorMap& colorMap, float width, float height, const Rect* visibleArea)
+{
+    NodeRef element{};
+    if (!FindElement(id, element))
+        return;
+
+    // Compile after building, lazy documents may add variables on the way.
+    CompiledColorMap compiledColorMap;
+    CompileColorMap(colorMap, compiledColorMap);
+    RenderElement(*mRenderer, element, compiledColorMap, width, height, visibleArea);
+}
+
+void SVGDocumentImpl::Render(const char* id, const CompiledColorMap& colorMap, float width, float height, const Rect* visibleArea)
+{
+    NodeRef element{};
+    if (!FindElement(id, element))
         return;
 
-    RenderElement(*mGroup, colorMap, width, height);
+    // Slots of another document mean nothing here, render the fallbacks.
+    const CompiledColorMap noColors;
+    RenderElement(*mRenderer, element, colorMap.mDocument == this ? colorMap : noColors, width, height, visibleArea);
 }
 
-void SVGDocumentImpl::Render(const char* id, const ColorMap& colorMap, float width, float height)
+bool SVGDocumentImpl::FindElement(const char* id, NodeRef& element)
 {
+    SVG_ASSERT(!mTrees.empty());
+    if (mTrees.empty())
+        return false;
+
+    if (!id)
+    {
+        BuildAllOnce();
+        element = {0, 0};
+        return true;
+    }
+
     // Referenced glyph identifiers shall be rendered as if they were contained in a <defs> section under
     // the root SVG element:
     // Therefore, the referenced shape/group should:
     // * inherit property values from the root SVG element,
     // * ignore all styling and transforms on ancestors.
     // https://docs.microsoft.com/en-us/typography/opentype/spec/svg#glyph-identifiers
+    std::unique_lock<std::mutex> lock(mBuildMutex, std::defer_lock);
+    if (mIsLazy)
+        lock.lock();
     auto elementIter = mIdToElementToMap.find(id);
-    if (elementIter != mIdToElementToMap.end())
-        RenderElement(*elementIter->second, colorMap, width, height);
+    if (elementIter == mIdToElementToMap.end() && mIsLazy)
+    {
+        // Elements that are only reachable through <use> are not indexed.
+        auto lazyElementIter = mLazyElements.find(id);
+        if (lazyElementIter != mLazyElements.end())
+            BuildElement(lazyElementIter->second);
+        else
+            BuildAll();
+        elementIter = mIdToElementToMap.find(id);
+    }
+    if (elementIter == mIdToElementToMap.end())
+        return false;
+
+    element = elementIter->second;
+    return true;
+}
+
+void SVGDocumentImpl::RenderTo(SVGRenderer& renderer, const char* id, const ColorMap& colorMap, float width, float height)
+{
+    // Compile after building, so that all variables have a slot.
+    BuildAllOnce();
+    CompiledColorMap compiledColorMap;
+    CompileColorMap(colorMap, compiledColorMap);
+    RenderTo(renderer, id, compiledColorMap, width, height);
+}
+
+void SVGDocumentImpl::RenderTo(
+    SVGRenderer& renderer, const char* id, const CompiledColorMap& colorMap, float width, float height, const Rect* visibleArea)
+{
+    // Building single elements of lazy documents would modify the render tree while other
+    // threads render it. Build everything at once instead.
+    BuildAllOnce();
+    if (mTrees.empty())
+        return;
+
+    NodeRef element{0, 0};
+    if (id)
+    {
+        auto elementIter = mIdToElementToMap.find(id);
+        if (elementIter == mIdToElementToMap.end())
+            return;
+        element = elementIter->second;
+    }
+    const CompiledColorMap noColors;
+    RenderElement(renderer, element, colorMap.mDocument == this ? colorMap : noColors, width, height, visibleArea);
+}
+
+void SVGDocumentImpl::CompileColorMap(const ColorMap& colorMap, CompiledColorMap& compiledColorMap) const
+{
+    // Building lazy documents adds variables.
+    std::unique_lock<std::mutex> lock(mBuildMutex, std::defer_lock);
+    if (mIsLazy)
+        lock.lock();
+    compiledColorMap.mDocument = this;
+    compiledColorMap.mColorMap.clear();
+    // Without colors all variables resolve to their fallbacks.
+    if (colorMap.empty())
+    {
+        compiledColorMap.mColors.clear();
+        compiledColorMap.mHasColor.clear();
+        return;
+    }
+
+    compiledColorMap.mColors.assign(mVariableNames.size(), Color{{0.0f, 0.0f, 0.0f, 1.0f}});
+    compiledColorMap.mHasColor.assign(mVariableNames.size(), false);
+    // Look up the shorter of both by name.
+    if (colorMap.size() < mVariableNames.size())
+    {
+        for (const auto& entry : colorMap)
+        {
+            auto slotIt = mVariableSlots.find(entry.first);
+            if (slotIt == mVariableSlots.end())
+                continue;
+            compiledColorMap.mColors[slotIt->second] = entry.second;
+            compiledColorMap.mHasColor[slotIt->second] = true;
+        }
+    }
+    else
+    {
+        for (std::uint32_t slot = 0; slot < mVariableNames.size(); ++slot)
+        {
+            auto colorIt = colorMap.find(mVariableNames[slot]);
+            if (colorIt == colorMap.end())
+                continue;
+            compiledColorMap.mColors[slot] = colorIt->second;
+            compiledColorMap.mHasColor[slot] = true;
+        }
+    }
+
+    // Variables of elements that get built later or of override styles do not have a
+    // slot yet. Keep the colors for them by name.
+#ifndef STYLE_SUPPORT
+    if (!mIsLazy)
+        return;
+#endif
+    for (const auto& entry : colorMap)
+    {
+        if (mVariableSlots.find(entry.first) == mVariableSlots.end())
+            compiledColorMap.mColorMap.insert(entry);
+    }
+}
+
+const Color& SVGDocumentImpl::ResolveVariable(const CompiledColorMap& colorMap, const Variable& var)
+{
+    if (var.slot < colorMap.mHasColor.size())
+        return colorMap.mHasColor[var.slot] ? colorMap.mColors[var.slot] : var.fallback;
+
+    auto colorIt = colorMap.mColorMap.find(var.name);
+    return colorIt != colorMap.mColorMap.end() ? colorIt->second : var.fallback;
+}
+
+std::uint32_t SVGDocumentImpl::VariableSlot(const std::string& name)
+{
+    auto slotIt = mVariableSlots.find(name);
+    if (slotIt != mVariableSlots.end())
+        return slotIt->second;
+
+    auto slot = static_cast<std::uint32_t>(mVariableNames.size());
+    mVariableNames.push_back(name);
+    mVariableSlots.emplace(name, slot);
+    return slot;
 }
 
-void SVGDocumentImpl::RenderElement(const Element& element, const ColorMap& colorMap, float width, float height)
+void SVGDocumentImpl::AssignSlot(ColorImpl& color)
+{
+    if (auto var = boost::get<Variable>(&color))
+        var->slot = VariableSlot(var->name);
+}
+
+void SVGDocumentImpl::AssignSlot(PaintImpl& paint)
+{
+    if (auto var = boost::get<Variable>(&paint))
+        var->slot = VariableSlot(var->name);
+}
+
+void SVGDocumentImpl::RenderElement(
+    SVGRenderer& renderer, NodeRef element, const CompiledColorMap& colorMap, float width, float height, const Rect* visibleArea)
 {
     float scale = width / mViewBox[2];
     if (scale > height / mViewBox[3])
         scale = height / mViewBox[3];
 
-    GraphicStyleImpl graphicStyle{};
-    graphicStyle.transform = mRenderer->CreateTransform();
+    auto scratch = AcquireScratch();
+    if (!scratch->rootTransform)
+        scratch->rootTransform = renderer.CreateTransform();
+    else
+        scratch->rootTransform->Set(1, 0, 0, 1, 0, 0);
+    GraphicStyle graphicStyle{};
+    graphicStyle.transform = scratch->rootTransform;
     graphicStyle.transform->Translate(-1 * mViewBox[0], -1 * mViewBox[1]);
     graphicStyle.transform->Scale(scale, scale);
 
-    mRenderer->Save(graphicStyle);
+    renderer.Save(graphicStyle);
+
+    // Bounds are relative to the root of the document, so elements rendered by id do
+    // not get culled.
+    CullArea cullArea;
+    auto isCulled = visibleArea && element.tree == 0 && element.node == 0 && SetCullArea(*visibleArea, scale, cullArea)
+        && UpdateBounds();
+    TraverseTree(renderer, colorMap, *scratch, isCulled ? &cullArea : nullptr, element.tree, element.node,
+        mTrees[element.tree][element.node].end);
+
+    renderer.Restore();
+    ReleaseScratch(std::move(scratch));
+}
+
+std::unique_ptr<RenderScratch> SVGDocumentImpl::AcquireScratch()
+{
+    {
+        std::lock_guard<std::mutex> lock(mRenderScratchMutex);
+        if (!mRenderScratch.empty())
+        {
+            auto scratch = std::move(mRenderScratch.back());
+            mRenderScratch.pop_back();
+            return scratch;
+        }
+    }
+    std::unique_ptr<RenderScratch> scratch(new RenderScratch);
+    scratch->fillStyles[1].paint = Gradient();
+    scratch->strokeStyles[1].paint = Gradient();
+    return scratch;
+}
+
+void SVGDocumentImpl::ReleaseScratch(std::unique_ptr<RenderScratch> scratch)
+{
+    std::lock_guard<std::mutex> lock(mRenderScratchMutex);
+    mRenderScratch.push_back(std::move(scratch));
+}
+
+std::shared_ptr<ImageData> SVGDocumentImpl::DecodeImage(SVGRenderer& renderer, const std::shared_ptr<ImageSource>& source)
+{
+    SVG_ASSERT(source != nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(mImageMutex);
+        if (source->decoded)
+        {
+            // Mark as most recently used.
+            mDecodedImages.splice(mDecodedImages.begin(), mDecodedImages, source->decodedPosition);
+            return source->decoded;
+        }
+    }
+
+    // Decoding happens while rendering. Broken images are skipped instead of aborting.
+    // Other threads keep drawing meanwhile. If two threads decode the same image at
+    // once, the first one to finish wins.
+    std::shared_ptr<ImageData> decoded;
+    try
+    {
+        decoded = renderer.CreateImageData(source->base64.data(), source->base64.size(), source->encoding);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+    if (!decoded)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mImageMutex);
+    if (source->decoded)
+    {
+        mDecodedImages.splice(mDecodedImages.begin(), mDecodedImages, source->decodedPosition);
+        return source->decoded;
+    }
+    source->decoded = std::move(decoded);
+    mDecodedImages.push_front(source);
+    source->decodedPosition = mDecodedImages.begin();
+    mDecodedImageSize += source->decodedSize;
+    // Never release the image that is about to be drawn.
+    if (mOptions.imageCacheSize)
+        ReleaseImages(std::max(mOptions.imageCacheSize, source->decodedSize));
+
+    return source->decoded;
+}
+
+void SVGDocumentImpl::PurgeImages(size_t budget)
+{
+    std::lock_guard<std::mutex> lock(mImageMutex);
+    ReleaseImages(budget);
+}
 
-    TraverseTree(colorMap, element);
+size_t SVGDocumentImpl::EstimateMemory() const
+{
+    size_t size = sizeof(*this);
+    for (const auto& tree : mTrees)
+        size += tree.capacity() * sizeof(Node);
+    size += mTrees.capacity() * sizeof(RenderTree) + mPaths.capacity() * sizeof(std::shared_ptr<Path>) + mImages.capacity() * sizeof(Image);
+    size += mGraphicStyles.Size() * sizeof(GraphicStyleImpl) + mFillStyles.Size() * sizeof(FillStyleImpl)
+        + mStrokeStyles.Size() * sizeof(StrokeStyleImpl) + mClassNames.Size() * sizeof(std::set<std::string>);
+    // Map nodes take about 4 pointers next to the entry.
+    for (const auto& id : mIdToElementToMap)
+        size += sizeof(id) + 4 * sizeof(void*) + id.first.capacity();
+
+    // Images may get decoded on any rendering. Count them as decoded, up to the size
+    // of the image cache.
+    std::unordered_set<const ImageSource*> sources;
+    size_t decodedSize{};
+    for (const auto& image : mImages)
+    {
+        if (!sources.insert(image.source.get()).second)
+            continue;
+        size += sizeof(ImageSource) + image.source->base64.capacity();
+        decodedSize += image.source->decodedSize;
+    }
+    if (mOptions.imageCacheSize)
+        decodedSize = std::min(decodedSize, mOptions.imageCacheSize);
+    return size + decodedSize;
+}
+
+void SVGDocumentImpl::ReleaseImages(size_t budget)
+{
+    // Release the least recently used images first.
+    while (!mDecodedImages.empty() && mDecodedImageSize > budget)
+    {
+        auto& source = mDecodedImages.back();
+        mDecodedImageSize -= source->decodedSize;
+        source->decoded.reset();
+        mDecodedImages.pop_back();
+    }
+}
 
-    mRenderer->Restore();
+SVGDocumentImpl::Node SVGDocumentImpl::CreateNode(
+    ElementType type, const GraphicStyleImpl& graphicStyle, const std::set<std::string>& classNames)
+{
+    Node node{};
+    node.type = type;
+    node.graphicStyle = mGraphicStyles.Intern(graphicStyle);
+    node.classNames = mClassNames.Intern(classNames);
+    return node;
 }
 
-void SVGDocumentImpl::AddChildToCurrentGroup(std::shared_ptr<Element> element, std::string idString)
+void SVGDocumentImpl::AddChildToCurrentGroup(const Node& node, std::string idString)
 {
     SVG_ASSERT(!mGroupStack.empty());
     if (mGroupStack.empty())
         return;
 
-    mGroupStack.top()->children.push_back(element);
+    auto treeIndex = mGroupStack.top().tree;
+    auto& tree = mTrees[treeIndex];
+    auto index = static_cast<std::uint32_t>(tree.size());
+    tree.push_back(node);
+    tree.back().end = index + 1;
+    // The root always spans the whole tree.
+    tree.front().end = index + 1;
 
     if (!idString.empty() && mIdToElementToMap.find(idString) == mIdToElementToMap.end())
-        mIdToElementToMap.emplace(std::move(idString), element);
+        mIdToElementToMap.emplace(std::move(idString), NodeRef{treeIndex, index});
+}
+
+void SVGDocumentImpl::OpenGroup(const Node& group, std::string idString)
+{
+    SVG_ASSERT(!mGroupStack.empty());
+    if (mGroupStack.empty())
+        return;
+
+    auto treeIndex = mGroupStack.top().tree;
+    AddChildToCurrentGroup(group, std::move(idString));
+    mGroupStack.push({treeIndex, static_cast<std::uint32_t>(mTrees[treeIndex].size() - 1)});
+}
+
+void SVGDocumentImpl::CloseGroup()
+{
+    const auto& group = mGroupStack.top();
+    auto& tree = mTrees[group.tree];
+    tree[group.node].end = static_cast<std::uint32_t>(tree.size());
+    mGroupStack.pop();
 }
 
-static void ResolveColorImpl(const ColorMap& colorMap, const ColorImpl& colorImpl, Color& color)
+std::uint32_t SVGDocumentImpl::OpenTree()
+{
+    auto treeIndex = static_cast<std::uint32_t>(mTrees.size());
+    auto root = CreateNode(ElementType::kGroup, GraphicStyleImpl(), std::set<std::string>());
+    root.end = 1;
+    mTrees.emplace_back(1, root);
+    mGroupStack.push({treeIndex, 0});
+    return treeIndex;
+}
+
+static void ResolveColorImpl(const CompiledColorMap& colorMap, const ColorImpl& colorImpl, Color& color)
 {
     if (colorImpl.type() == typeid(Variable))
-    {
-        const auto& var = boost::get<Variable>(colorImpl);
-        auto colorIt = colorMap.find(var.first);
-        color = colorIt != colorMap.end() ? colorIt->second : var.second;
-    }
+        color = SVGDocumentImpl::ResolveVariable(colorMap, boost::get<Variable>(colorImpl));
     else if (colorImpl.type() == typeid(Color))
         color = boost::get<Color>(colorImpl);
     else
@@ -1083,30 +2294,25 @@ static void ResolveColorImpl(const ColorMap& colorMap, const ColorImpl& colorImp
         color = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
 }
 
-static void ResolvePaintImpl(const ColorMap& colorMap, const PaintImpl& internalPaint, const Color& currentColor, Paint& paint)
+static void ResolvePaintImpl(const CompiledColorMap& colorMap, const PaintImpl& internalPaint, const Color& currentColor, Paint& paint)
 {
     if (internalPaint.type() == typeid(Variable))
+        paint = SVGDocumentImpl::ResolveVariable(colorMap, boost::get<Variable>(internalPaint));
+    else if (internalPaint.type() == typeid(std::shared_ptr<const GradientImpl>))
     {
-        const auto& var = boost::get<Variable>(internalPaint);
-        auto colorIt = colorMap.find(var.first);
-        paint = colorIt != colorMap.end() ? colorIt->second : var.second;
-    }
-    else if (internalPaint.type() == typeid(GradientImpl))
-    {
-        // Stop colors may have variables as well.
-        const auto& internalGradient = boost::get<GradientImpl>(internalPaint);
-        paint = std::move(internalGradient);
+        // Stop colors may have variables as well. A gradient that paint holds already
+        // keeps the storage of its color stops.
+        const auto& internalGradient = *boost::get<std::shared_ptr<const GradientImpl>>(internalPaint);
+        if (paint.type() != typeid(Gradient))
+            paint = Gradient();
         auto& gradient = boost::get<Gradient>(paint);
+        gradient = static_cast<const Gradient&>(internalGradient);
         for (auto& colorStop : internalGradient.internalColorStops)
         {
             Color stopColor{{0, 0, 0, 1.0}};
             const auto& colorImpl = std::get<1>(colorStop);
             if (colorImpl.type() == typeid(Variable))
-            {
-                const auto& var = boost::get<Variable>(colorImpl);
-                auto colorIt = colorMap.find(var.first);
-                stopColor = colorIt != colorMap.end() ? colorIt->second : var.second;
-            }
+                stopColor = SVGDocumentImpl::ResolveVariable(colorMap, boost::get<Variable>(colorImpl));
             else if (colorImpl.type() == typeid(Color))
                 stopColor = boost::get<Color>(colorImpl);
             else
@@ -1126,55 +2332,197 @@ static void ResolvePaintImpl(const ColorMap& colorMap, const PaintImpl& internal
         SVG_ASSERT_MSG(false, "Unhandled PaintImpl type");
 }
 
-void SVGDocumentImpl::TraverseTree(const ColorMap& colorMap, const Element& element)
+static bool IsGradient(const PaintImpl& internalPaint)
+{
+    return internalPaint.type() == typeid(std::shared_ptr<const GradientImpl>);
+}
+
+static bool HasVariables(const PaintImpl& internalPaint)
 {
-    // Inheritance doesn't work for override styles. Since override styles
-    // are deprecated, we are not going to fix this nor is this expected by
-    // (still existing) clients.
-    auto graphicStyle = element.graphicStyle;
-    FillStyleImpl fillStyle{};
-    StrokeStyleImpl strokeStyle{};
-    // Do not draw element if an applied clipPath has no content.
-    if (graphicStyle.clippingPath && !graphicStyle.clippingPath->hasClipContent)
+    if (internalPaint.type() == typeid(Variable))
+        return true;
+    if (!IsGradient(internalPaint))
+        return false;
+    for (const auto& colorStop : boost::get<std::shared_ptr<const GradientImpl>>(internalPaint)->internalColorStops)
+    {
+        if (std::get<1>(colorStop).type() == typeid(Variable))
+            return true;
+    }
+    return false;
+}
+
+void SVGDocumentImpl::PreResolvePaint(FillStyleImpl& fillStyle)
+{
+    fillStyle.isResolved = !HasVariables(fillStyle.internalPaint)
+        && !(fillStyle.internalPaint.type() == typeid(ColorKeys) && fillStyle.color.type() == typeid(Variable));
+    if (!fillStyle.isResolved)
         return;
-    switch (element.Type())
-    {
-    case ElementType::kGraphic:
-    {
-        const auto& graphic = static_cast<const Graphic&>(element);
-        // TODO: Since we keep the original fill, stroke and color property values
-        // we should be able to do w/o a copy.
-        fillStyle = graphic.fillStyle;
-        strokeStyle = graphic.strokeStyle;
-        ApplyCSSStyle(graphic.classNames, graphicStyle, fillStyle, strokeStyle);
-        // If we have a CSS var() function we need to replace the placeholder with
-        // an actual color from our externally provided color map here.
+
+    Color color{{0.0f, 0.0f, 0.0f, 1.0f}};
+    ResolveColorImpl(CompiledColorMap(), fillStyle.color, color);
+    ResolvePaintImpl(CompiledColorMap(), fillStyle.internalPaint, color, fillStyle.paint);
+}
+
+void SVGDocumentImpl::PreResolvePaint(StrokeStyleImpl& strokeStyle)
+{
+    // currentColor comes from the fill style of the element.
+    strokeStyle.isResolved = !HasVariables(strokeStyle.internalPaint) && strokeStyle.internalPaint.type() != typeid(ColorKeys);
+    if (strokeStyle.isResolved)
+        ResolvePaintImpl(CompiledColorMap(), strokeStyle.internalPaint, Color{{0.0f, 0.0f, 0.0f, 1.0f}}, strokeStyle.paint);
+}
+
+// The scratch style takes all properties but the paint from style.
+static const FillStyle& ResolveStyle(
+    const CompiledColorMap& colorMap, const FillStyleImpl& fillStyle, const Color& currentColor, RenderScratch& scratch)
+{
+    if (fillStyle.isResolved)
+        return fillStyle;
+
+    auto& resolved = scratch.fillStyles[IsGradient(fillStyle.internalPaint)];
+    resolved.hasFill = fillStyle.hasFill;
+    resolved.fillRule = fillStyle.fillRule;
+    resolved.fillOpacity = fillStyle.fillOpacity;
+    ResolvePaintImpl(colorMap, fillStyle.internalPaint, currentColor, resolved.paint);
+    return resolved;
+}
+
+static const StrokeStyle& ResolveStyle(
+    const CompiledColorMap& colorMap, const StrokeStyleImpl& strokeStyle, const Color& currentColor, RenderScratch& scratch)
+{
+    if (strokeStyle.isResolved)
+        return strokeStyle;
+
+    auto& resolved = scratch.strokeStyles[IsGradient(strokeStyle.internalPaint)];
+    resolved.hasStroke = strokeStyle.hasStroke;
+    resolved.strokeOpacity = strokeStyle.strokeOpacity;
+    resolved.lineWidth = strokeStyle.lineWidth;
+    resolved.lineCap = strokeStyle.lineCap;
+    resolved.lineJoin = strokeStyle.lineJoin;
+    resolved.miterLimit = strokeStyle.miterLimit;
+    resolved.dashArray = strokeStyle.dashArray;
+    resolved.dashOffset = strokeStyle.dashOffset;
+    ResolvePaintImpl(colorMap, strokeStyle.internalPaint, currentColor, resolved.paint);
+    return resolved;
+}
+
+void SVGDocumentImpl::DrawGraphic(SVGRenderer& renderer, const CompiledColorMap& colorMap, RenderScratch& scratch, const Node& node)
+{
+    const auto& path = *mPaths[node.resource];
+    const auto& graphicStyle = mGraphicStyles[node.graphicStyle];
+    const auto& fillStyle = mFillStyles[node.fillStyle];
+    const auto& strokeStyle = mStrokeStyles[node.strokeStyle];
+    if (HasOverrideStyle(node))
+    {
+        // Override styles are deprecated. They get applied to copies of the styles.
+        auto overrideGraphicStyle = graphicStyle;
+        auto overrideFillStyle = fillStyle;
+        auto overrideStrokeStyle = strokeStyle;
+        ApplyCSSStyle(mClassNames[node.classNames], overrideGraphicStyle, overrideFillStyle, overrideStrokeStyle);
         Color color{{0.0f, 0.0f, 0.0f, 1.0f}};
-        ResolveColorImpl(colorMap, fillStyle.color, color);
-        ResolvePaintImpl(colorMap, fillStyle.internalPaint, color, fillStyle.paint);
-        ResolvePaintImpl(colorMap, strokeStyle.internalPaint, color, strokeStyle.paint);
-        mRenderer->DrawPath(*(graphic.path.get()), graphicStyle, fillStyle, strokeStyle);
-        break;
+        ResolveColorImpl(colorMap, overrideFillStyle.color, color);
+        ResolvePaintImpl(colorMap, overrideFillStyle.internalPaint, color, overrideFillStyle.paint);
+        ResolvePaintImpl(colorMap, overrideStrokeStyle.internalPaint, color, overrideStrokeStyle.paint);
+        renderer.DrawPath(path, overrideGraphicStyle, overrideFillStyle, overrideStrokeStyle);
+        return;
     }
-    case ElementType::kImage:
+
+    if (fillStyle.isResolved && strokeStyle.isResolved)
     {
-        const auto& image = static_cast<const Image&>(element);
-        ApplyCSSStyle(image.classNames, graphicStyle, fillStyle, strokeStyle);
-        mRenderer->DrawImage(*(image.imageData.get()), graphicStyle, image.clipArea, image.fillArea);
-        break;
+        renderer.DrawPath(path, graphicStyle, fillStyle, strokeStyle);
+        return;
     }
-    case ElementType::kGroup:
+
+    // If we have a CSS var() function we need to replace the placeholder with
+    // an actual color from our externally provided color map here.
+    Color color{{0.0f, 0.0f, 0.0f, 1.0f}};
+    ResolveColorImpl(colorMap, fillStyle.color, color);
+    renderer.DrawPath(path, graphicStyle, ResolveStyle(colorMap, fillStyle, color, scratch),
+        ResolveStyle(colorMap, strokeStyle, color, scratch));
+}
+
+void SVGDocumentImpl::DrawImage(SVGRenderer& renderer, const Node& node)
+{
+    const auto& image = mImages[node.resource];
+    auto imageData = DecodeImage(renderer, image.source);
+    if (!imageData || imageData->Width() <= 0 || imageData->Height() <= 0)
+        return;
+
+    if (HasOverrideStyle(node))
     {
-        const auto& group = static_cast<const Group&>(element);
-        ApplyCSSStyle(group.classNames, graphicStyle, fillStyle, strokeStyle);
-        mRenderer->Save(group.graphicStyle);
-        for (const auto& child : group.children)
-            TraverseTree(colorMap, *child);
-        mRenderer->Restore();
-        break;
+        auto overrideGraphicStyle = mGraphicStyles[node.graphicStyle];
+        FillStyleImpl fillStyle{};
+        StrokeStyleImpl strokeStyle{};
+        ApplyCSSStyle(mClassNames[node.classNames], overrideGraphicStyle, fillStyle, strokeStyle);
+        renderer.DrawImage(*imageData, overrideGraphicStyle, image.clipArea, image.fillArea);
+        return;
     }
-    default:
-        SVG_ASSERT_MSG(false, "Unknown element type");
+    renderer.DrawImage(*imageData, mGraphicStyles[node.graphicStyle], image.clipArea, image.fillArea);
+}
+
+void SVGDocumentImpl::TraverseTree(SVGRenderer& renderer, const CompiledColorMap& colorMap, RenderScratch& scratch,
+    const CullArea* cullArea, std::uint32_t treeIndex, std::uint32_t first, std::uint32_t last)
+{
+    const auto& tree = mTrees[treeIndex];
+    // Ends of the groups that are saved on the renderer, innermost last. The groups
+    // of the traversals this one is nested in stay below base.
+    auto& groupEnds = scratch.groupEnds;
+    const auto base = groupEnds.size();
+    auto i = first;
+    for (;;)
+    {
+        while (groupEnds.size() > base && groupEnds.back() == i)
+        {
+            renderer.Restore();
+            groupEnds.pop_back();
+        }
+        if (i >= last)
+            break;
+
+        const auto& node = tree[i];
+        // Inheritance doesn't work for override styles. Since override styles
+        // are deprecated, we are not going to fix this nor is this expected by
+        // (still existing) clients.
+        const auto& graphicStyle = mGraphicStyles[node.graphicStyle];
+        // Do not draw element if an applied clipPath has no content.
+        if (graphicStyle.clippingPath && !graphicStyle.clippingPath->hasClipContent)
+        {
+            i = node.end;
+            continue;
+        }
+        // Skip elements and whole groups outside of the visible area.
+        if (cullArea && !IsVisible(*cullArea, treeIndex, i))
+        {
+            i = node.end;
+            continue;
+        }
+        switch (node.type)
+        {
+        case ElementType::kGraphic:
+            DrawGraphic(renderer, colorMap, scratch, node);
+            break;
+        case ElementType::kImage:
+            DrawImage(renderer, node);
+            break;
+        case ElementType::kGroup:
+            renderer.Save(graphicStyle);
+            // The children follow.
+            groupEnds.push_back(node.end);
+            break;
+        case ElementType::kInstance:
+        {
+            renderer.Save(graphicStyle);
+            CullArea instanceCullArea;
+            auto isCulled = cullArea && InstanceCullArea(*cullArea, treeIndex, i, instanceCullArea);
+            // Skip the root of the content, the instance takes its place.
+            TraverseTree(renderer, colorMap, scratch, isCulled ? &instanceCullArea : nullptr, node.resource, 1,
+                mTrees[node.resource].front().end);
+            renderer.Restore();
+            break;
+        }
+        default:
+            SVG_ASSERT_MSG(false, "Unknown element type");
+        }
+        ++i;
     }
 }
 
@@ -1184,6 +2532,7 @@ void SVGDocumentImpl::ApplyCSSStyle(
     const std::set<std::string>&, GraphicStyleImpl&, FillStyleImpl&, StrokeStyleImpl&) {}
 void SVGDocumentImpl::ParseStyleAttr(XMLNode*, std::vector<PropertySet>&, std::set<std::string>&) {}
 void SVGDocumentImpl::ParseStyle(XMLNode*) {}
+bool SVGDocumentImpl::HasOverrideStyle(const Node&) const { return false; }
 #endif
 
 } // namespace SVGNative
@@ -12,6 +12,11 @@ governing permissions and limitations under the License.
 
 #pragma once
 
+#include "SVGDocument.h"
+#include "SVGInternTable.h"
+#include "SVGParseBudget.h"
+#include "SVGPathRecorder.h"
+#include "SVGPropertyNames.h"
 #include "SVGRenderer.h"
 #ifdef STYLE_SUPPORT
 #include "StyleSheet/Document.h"
@@ -19,18 +24,25 @@ governing permissions and limitations under the License.
 #endif
 
 #include <array>
+#include <atomic>
 #include <boost/property_tree/detail/xml_parser_read_rapidxml.hpp>
+#include <limits>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <stack>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace SVGNative
 {
 using XMLNode = boost::property_tree::detail::rapidxml::xml_node<>;
 using XMLDocument = boost::property_tree::detail::rapidxml::xml_document<>;
+using XMLAttribute = boost::property_tree::detail::rapidxml::xml_attribute<>;
 
 struct GradientImpl;
 
@@ -40,9 +52,28 @@ enum class ColorKeys
     kCurrentColor
 };
 
-using Variable = std::pair<std::string, Color>;
+// CSS custom property var(--name, fallback). slot numbers the distinct names used in
+// a document, see SVGDocumentImpl::VariableSlot().
+struct Variable
+{
+    // Variables without a slot get resolved by name.
+    static const std::uint32_t kNoSlot = 0xFFFFFFFF;
+
+    Variable(std::string name, const Color& fallback)
+        : name(std::move(name))
+        , fallback(fallback)
+    {
+    }
+
+    std::string name;
+    Color fallback;
+    std::uint32_t slot{kNoSlot};
+
+    bool operator==(const Variable& other) const { return name == other.name && fallback == other.fallback; }
+};
 using ColorImpl = boost::variant<Color, Variable, ColorKeys>;
-using PaintImpl = boost::variant<Color, GradientImpl, Variable, ColorKeys>;
+// Gradients are immutable once parsed. All paints referencing the same gradient share it.
+using PaintImpl = boost::variant<Color, std::shared_ptr<const GradientImpl>, Variable, ColorKeys>;
 using ColorStopImpl = std::tuple<float, ColorImpl, float>;
 #ifdef STYLE_SUPPORT
 using PropertySet = StyleSheet::CssPropertySet;
@@ -58,6 +89,8 @@ struct GradientImpl : public Gradient
 struct FillStyleImpl : public FillStyle
 {
     PaintImpl internalPaint = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
+    // True if paint was resolved when parsing since it does not depend on the color map.
+    bool isResolved{};
 
     // Other inherited properties. We handle them here for simplicity.
     bool visibility{true};
@@ -68,6 +101,31 @@ struct FillStyleImpl : public FillStyle
 struct StrokeStyleImpl : public StrokeStyle
 {
     PaintImpl internalPaint = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
+    // True if paint was resolved when parsing since it does not depend on the color
+    // map or on currentColor.
+    bool isResolved{};
+};
+
+// Axis-aligned bounding box. Empty while minX > maxX, unbounded if any side is infinite.
+struct Box
+{
+    float minX = std::numeric_limits<float>::infinity();
+    float minY = std::numeric_limits<float>::infinity();
+    float maxX = -std::numeric_limits<float>::infinity();
+    float maxY = -std::numeric_limits<float>::infinity();
+};
+
+// Storage reused by renderings of a document so that rendering it again does not
+// allocate. Each rendering has one of its own.
+struct RenderScratch
+{
+    // Ends of the groups that are saved on the renderer, see TraverseTree().
+    std::vector<std::uint32_t> groupEnds;
+    // Styles resolved with a color map, indexed by whether the paint is a gradient.
+    // The paints never change their type and keep the storage of the color stops.
+    std::array<FillStyle, 2> fillStyles;
+    std::array<StrokeStyle, 2> strokeStyles;
+    std::shared_ptr<Transform> rootTransform;
 };
 
 struct GraphicStyleImpl : public GraphicStyle
@@ -78,6 +136,24 @@ struct GraphicStyleImpl : public GraphicStyle
     ColorImpl stopColor = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
 };
 
+// Hash and equality of styles for InternTable. Transforms, clipping paths and
+// gradients compare by identity.
+struct StyleHash
+{
+    size_t operator()(const FillStyleImpl& fillStyle) const;
+    size_t operator()(const StrokeStyleImpl& strokeStyle) const;
+    size_t operator()(const GraphicStyleImpl& graphicStyle) const;
+    size_t operator()(const std::set<std::string>& classNames) const;
+};
+
+struct StyleEqual
+{
+    bool operator()(const FillStyleImpl& a, const FillStyleImpl& b) const;
+    bool operator()(const StrokeStyleImpl& a, const StrokeStyleImpl& b) const;
+    bool operator()(const GraphicStyleImpl& a, const GraphicStyleImpl& b) const;
+    bool operator()(const std::set<std::string>& a, const std::set<std::string>& b) const;
+};
+
 class SVGDocumentImpl
 {
 public:
@@ -85,75 +161,100 @@ public:
     {
         kImage,
         kGraphic,
-        kGroup
+        kGroup,
+        // Created for a <use> element. The referenced content gets parsed once for
+        // each inherited style and is shared by all instances.
+        kInstance
     };
 
-    struct Element
-    {
-        Element(GraphicStyleImpl& aGraphicStyle, std::set<std::string>& aClasses)
-            : graphicStyle{aGraphicStyle}
-            , classNames{aClasses}
-        {
-        }
-
-        virtual ~Element() = default;
+    // Index of a style in one of the style tables of the document.
+    using StyleIndex = std::uint32_t;
 
-        GraphicStyleImpl graphicStyle;
-        std::set<std::string> classNames;
-        virtual ElementType Type() const = 0;
+    // Base64 encoded image. The renderer decodes it on first use. The decoded image
+    // may get released and decoded again later.
+    struct ImageSource
+    {
+        std::string base64;
+        ImageEncoding encoding{};
+        // Estimated memory of the decoded image in bytes.
+        size_t decodedSize{};
+        std::shared_ptr<ImageData> decoded;
+        // Entry in mDecodedImages while decoded is set.
+        std::list<std::shared_ptr<ImageSource>>::iterator decodedPosition;
     };
 
-    struct Image : public Element
+    struct Image
     {
-        Image(GraphicStyleImpl& aGraphicStyle, std::set<std::string>& aClasses, std::shared_ptr<ImageData> aImageData,
-            const Rect& aClipArea, const Rect& aFillArea)
-            : Element(aGraphicStyle, aClasses)
-            , imageData{std::move(aImageData)}
-            , clipArea{aClipArea}
-            , fillArea{aFillArea}
-        {
-        }
-
-        std::shared_ptr<ImageData> imageData;
+        std::shared_ptr<ImageSource> source;
         Rect clipArea;
         Rect fillArea;
-        ElementType Type() const override { return ElementType::kImage; }
     };
 
-    struct Group : public Element
+    // Element of a render tree. Styles, paths and images are stored once per document
+    // and nodes refer to them by index.
+    struct Node
     {
-        Group(GraphicStyleImpl& aGraphicStyle, std::set<std::string>& aClasses)
-            : Element(aGraphicStyle, aClasses)
-        {
-        }
-
-        std::vector<std::shared_ptr<Element>> children;
-        ElementType Type() const override { return ElementType::kGroup; }
+        ElementType type;
+        StyleIndex graphicStyle;
+        StyleIndex classNames;
+        // Only used by graphics.
+        StyleIndex fillStyle;
+        StyleIndex strokeStyle;
+        // Index into mPaths for graphics, into mImages for images and into mTrees for
+        // the content of instances.
+        std::uint32_t resource;
+        // One past the index of the last descendant.
+        std::uint32_t end;
     };
 
-    struct Graphic : public Element
+    // Nodes of a tree in pre-order. The children of a group follow it directly, each
+    // followed by its own descendants. The root is a group spanning the whole tree.
+    using RenderTree = std::vector<Node>;
+
+    // Position of a node in mTrees.
+    struct NodeRef
     {
-        Graphic(GraphicStyleImpl& aGraphicStyle, std::set<std::string>& aClasses, FillStyleImpl& aFillStyle, StrokeStyleImpl& aStrokeStyle,
-            std::shared_ptr<Path> aPath)
-            : Element(aGraphicStyle, aClasses)
-            , fillStyle{aFillStyle}
-            , strokeStyle{aStrokeStyle}
-            , path{std::move(aPath)}
-        {
-        }
-
-        FillStyleImpl fillStyle;
-        StrokeStyleImpl strokeStyle;
-        std::shared_ptr<Path> path;
-
-        ElementType Type() const override { return ElementType::kGraphic; }
+        std::uint32_t tree;
+        std::uint32_t node;
     };
 
-    SVGDocumentImpl(std::shared_ptr<SVGRenderer> renderer);
+    SVGDocumentImpl(std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options = ParseOptions());
     ~SVGDocumentImpl() {}
 
+    // Parses the NUL-terminated text into mXMLDocument without modifying it. text must
+    // outlive mXMLDocument. Checks the nesting depth against the limits first since
+    // RapidXML recurses once per level.
+    void ParseXML(const char* text);
     void TraverseSVGTree();
 
+    // True while the render tree gets built on demand. The XML DOM must stay alive then.
+    bool IsLazy() const { return mIsLazy; }
+
+    // Number of shapes that got the Path of an identical shape parsed earlier.
+    size_t DeduplicatedPathCount() const { return mDeduplicatedPathCount; }
+
+    // Binary form of the render tree, see SVGDocumentBinary.cpp. Serialize() returns
+    // false if the document was not parsed with ParseOptions::isSerializable.
+    // Deserialize() replaces the render tree of a new document and throws on
+    // malformed data.
+    bool Serialize(std::vector<char>& data);
+    void Deserialize(const char* data, size_t length);
+
+    // Incremental construction of the render tree. Used by SVGStreamingParser
+    // which never holds the complete XML DOM in memory. StartPass() starts the
+    // time limit for the elements parsed next.
+    void StartPass();
+    bool ParseRoot(XMLNode* rootNode);
+    void ParseGroupStart(XMLNode* node);
+    void ParseGroupEnd();
+    void ParseDefsStart(XMLNode* node);
+    void ParseDefsEnd();
+    void ParseSymbolStart(XMLNode* node);
+    void ParseSymbolEnd();
+    // Parses a single element. Children of <defs> are parsed as resources.
+    void ParseFragment(const char* text, size_t length, bool isResource);
+    void FinishParsing();
+
     enum class Result
     {
         kSuccess,
@@ -172,47 +273,154 @@ public:
     void AddCustomCSS(const StyleSheet::CssDocument* cssDocument);
     void ClearCustomCSS();
 #endif
-    void Render(const ColorMap& colorMap, float width, float height);
-    void Render(const char* id, const ColorMap& colorMap, float width, float height);
+    // Renders the whole document if id is nullptr.
+    // Skips elements outside of visibleArea if it is not nullptr, see RenderElement().
+    void Render(const char* id, const ColorMap& colorMap, float width, float height, const Rect* visibleArea = nullptr);
+    void Render(const char* id, const CompiledColorMap& colorMap, float width, float height, const Rect* visibleArea = nullptr);
+    // Renders the whole document if id is nullptr. Safe to call from several threads at
+    // once with different renderers. Builds lazy documents completely on the first call.
+    void RenderTo(SVGRenderer& renderer, const char* id, const ColorMap& colorMap, float width, float height);
+    void RenderTo(SVGRenderer& renderer, const char* id, const CompiledColorMap& colorMap, float width, float height,
+        const Rect* visibleArea = nullptr);
+    // Looks up the slot of every variable name the document uses so far.
+    void CompileColorMap(const ColorMap& colorMap, CompiledColorMap& compiledColorMap) const;
+    // The color of var in colorMap or its fallback.
+    static const Color& ResolveVariable(const CompiledColorMap& colorMap, const Variable& var);
+    void PurgeImages(size_t budget);
+    // Approximate memory taken by the document, excluding the renderer objects.
+    size_t EstimateMemory() const;
 
     XMLDocument mXMLDocument;
     std::array<float, 4> mViewBox;
     std::shared_ptr<SVGRenderer> mRenderer;
+    ParseOptions mOptions;
 
 private:
+    void TranslateEntities();
     bool HasAttr(XMLNode* node, const char* attrName);
     float ParseLengthFromAttr(XMLNode* child, const char* attrName, LengthType lengthType = LengthType::kHorizontal, float fallback = 0);
+    std::unique_ptr<Transform> ParseTransform(const char* transformString, size_t length);
+    // Renderer transform for the matrix {a, b, c, d, tx, ty}.
+    std::unique_ptr<Transform> CreateTransform(const std::array<float, 6>& matrix);
+    // Multiplies transform with other from the right like Transform::Concat().
+    void ConcatTransform(Transform& transform, const Transform& other);
     float RelativeLength(LengthType lengthType) const;
 
     float ParseColorStop(XMLNode* node, std::vector<SVGNative::ColorStopImpl>& colorStops, float lastOffset);
     void ParseColorStops(XMLNode* node, SVGNative::GradientImpl& gradient);
     void ParseGradient(XMLNode* gradient);
+    static std::shared_ptr<const GradientImpl> ResolveGradient(GradientImpl gradient, const std::array<float, 4>& viewBox);
+    void ResolveGradients();
 
     void ParseResources(XMLNode* node);
     void ParseResource(XMLNode* node);
 
     void ParseChildren(XMLNode* node);
     void ParseChild(XMLNode* node);
+    // Returns the index of the tree with the content.
+    std::uint32_t ParseUseContent(XMLNode* node, StyleIndex fillStyle, StyleIndex strokeStyle, size_t useDepth);
+
+    bool IndexChildren(XMLNode* node);
+    void BuildElement(XMLNode* node);
+    void BuildAll();
+    // Builds a lazy document completely. Safe to call from several threads at once,
+    // the render tree does not change anymore afterwards.
+    void BuildAllOnce();
+
+    std::shared_ptr<Path> ParseShape(XMLNode* node, ElementTag elementTag);
+    // Adds the outline of a shape element to path. Returns false if the element is no shape
+    // or must not be rendered.
+    bool ParseOutline(XMLNode* node, ElementTag elementTag, Path& path);
+    // Returns the renderer Path for outline. Identical outlines share the same Path.
+    std::shared_ptr<Path> SharePath(const PathRecorder& outline);
+    // Returns a new renderer Path with outline replayed into it.
+    std::shared_ptr<Path> CreatePath(const PathRecorder& outline);
+    void PreparsePaths(XMLNode* rootNode);
+
+    // Parses the style of node. fillStyle and strokeStyle are the inherited styles on input
+    // and get replaced if node overrides any of their properties.
+    GraphicStyleImpl ParseGraphic(XMLNode* node, StyleIndex& fillStyle, StyleIndex& strokeStyle, std::set<std::string>& classNames);
+    void ParseFillProperties(FillStyleImpl& fillStyle, const PropertySlots& properties);
+    void ParseStrokeProperties(StrokeStyleImpl& strokeStyle, const PropertySlots& properties);
+    void ParseGraphicsProperties(GraphicStyleImpl& graphicsStyle, const PropertySlots& properties);
+    // Numbers the distinct variable names in the order they appear.
+    std::uint32_t VariableSlot(const std::string& name);
+    void AssignSlot(ColorImpl& color);
+    void AssignSlot(PaintImpl& paint);
+
+    void ParsePresentationAttributes(XMLNode* node, PropertySlots& properties);
+    static PropertySlots ClassifyProperties(const PropertySet& propertySet);
+
+    // Finds the element to render for id and builds it if the document is lazy. The root
+    // for nullptr.
+    bool FindElement(const char* id, NodeRef& element);
+    // Culls by visibleArea on the surface if it is not nullptr. Only the whole document
+    // gets culled.
+    void RenderElement(SVGRenderer& renderer, NodeRef element, const CompiledColorMap& colorMap, float width, float height,
+        const Rect* visibleArea = nullptr);
+    std::unique_ptr<RenderScratch> AcquireScratch();
+    void ReleaseScratch(std::unique_ptr<RenderScratch> scratch);
+    // The returned image stays valid while it gets drawn, even if another thread
+    // releases it from the cache meanwhile.
+    std::shared_ptr<ImageData> DecodeImage(SVGRenderer& renderer, const std::shared_ptr<ImageSource>& source);
+    // Releases decoded images until they take at most budget bytes. mImageMutex must be locked.
+    void ReleaseImages(size_t budget);
+
+    // Culling state of a traversal. Nodes whose bounds, mapped to the surface, miss
+    // visibleArea are skipped.
+    struct CullArea
+    {
+        Box visibleArea;
+        // From the root of the traversed tree to the surface.
+        std::array<float, 6> toSurface;
+    };
 
-    std::unique_ptr<Path> ParseShape(XMLNode* node);
-
-    GraphicStyleImpl ParseGraphic(XMLNode* node, FillStyleImpl& fillStyle, StrokeStyleImpl& strokeStyle, std::set<std::string>& classNames);
-    void ParseFillProperties(FillStyleImpl& fillStyle, const PropertySet& propertySet);
-    void ParseStrokeProperties(StrokeStyleImpl& strokeStyle, const PropertySet& propertySet);
-    void ParseGraphicsProperties(GraphicStyleImpl& graphicsStyle, const PropertySet& propertySet);
-
-    PropertySet ParsePresentationAttributes(XMLNode* node);
-
-    void RenderElement(const Element& element, const ColorMap& colorMap, float width, float height);
-
-    void TraverseTree(const ColorMap& colorMap, const Element&);
-
+    // Renders the nodes from first to last, excluding last, of a tree. The range
+    // must consist of complete subtrees. cullArea may be nullptr.
+    void TraverseTree(SVGRenderer& renderer, const CompiledColorMap& colorMap, RenderScratch& scratch, const CullArea* cullArea,
+        std::uint32_t tree, std::uint32_t first, std::uint32_t last);
+    void DrawGraphic(SVGRenderer& renderer, const CompiledColorMap& colorMap, RenderScratch& scratch, const Node& node);
+    void DrawImage(SVGRenderer& renderer, const Node& node);
+    // Resolves the paint of styles that do not depend on the color map ahead of rendering.
+    static void PreResolvePaint(FillStyleImpl& fillStyle);
+    static void PreResolvePaint(StrokeStyleImpl& strokeStyle);
+
+    // Bounds of the render trees, see SVGDocumentBounds.cpp. UpdateBounds() computes
+    // the bounds of trees that are new or grew since the last call. Returns false if
+    // the document does not keep the geometry needed.
+    bool UpdateBounds();
+    void RecordPathBounds(const Path& path, const PathRecorder& outline);
+    // Returns false if visibleArea is no valid rectangle.
+    bool SetCullArea(const Rect& visibleArea, float scale, CullArea& cullArea) const;
+    void ComputeTreeBounds(std::uint32_t tree);
+    // Bounds of the outline of a graphic including its stroke, before its transform.
+    Box GraphicBounds(const Node& node) const;
+    bool IsVisible(const CullArea& cullArea, std::uint32_t tree, std::uint32_t node) const;
+    bool InstanceCullArea(const CullArea& cullArea, std::uint32_t tree, std::uint32_t node, CullArea& instanceCullArea) const;
+    // Matrices get recorded for serialization and for culling.
+    bool RecordsGeometry() const { return mOptions.isSerializable || mOptions.computeBounds; }
+
+    // True if an override style may apply to node. Deprecated.
+    bool HasOverrideStyle(const Node& node) const;
     void ApplyCSSStyle(
         const std::set<std::string>& classNames, GraphicStyleImpl& graphicStyle, FillStyleImpl& fillStyle, StrokeStyleImpl& strokeStyle);
     void ParseStyleAttr(XMLNode* node, std::vector<PropertySet>& propertySets, std::set<std::string>& classNames);
     void ParseStyle(XMLNode* child);
 
-    void AddChildToCurrentGroup(std::shared_ptr<Element> element, std::string idString);
+    Node CreateNode(ElementType type, const GraphicStyleImpl& graphicStyle, const std::set<std::string>& classNames);
+    void AddChildToCurrentGroup(const Node& node, std::string idString);
+    // Adds group to the current group and makes it the current group.
+    void OpenGroup(const Node& group, std::string idString);
+    void CloseGroup();
+    // Starts a new tree and makes its root the current group.
+    std::uint32_t OpenTree();
+    void PushGroup(const GraphicStyleImpl& graphicStyle, const std::set<std::string>& classNames,
+        StyleIndex fillStyle, StyleIndex strokeStyle, std::string idString);
+    void PopGroup();
+    void PushDefs(StyleIndex fillStyle, StyleIndex strokeStyle);
+    void PopDefs();
+    // Starts a tree for the symbol and opens its group. Both need a CloseGroup().
+    void PushSymbol(XMLNode* node, GraphicStyleImpl& graphicStyle, std::set<std::string>& classNames, std::string idString);
 
 private:
     // All stroke and fill CSS properties are so called
@@ -221,8 +429,8 @@ private:
     // specifies from ancestors.
     // We need to keep the stack of settings in based on DOM
     // hierarchy.
-    std::stack<StrokeStyleImpl> mStrokeStyleStack;
-    std::stack<FillStyleImpl> mFillStyleStack;
+    std::stack<StyleIndex> mStrokeStyleStack;
+    std::stack<StyleIndex> mFillStyleStack;
 
 #ifdef STYLE_SUPPORT
     const StyleSheet::CssDocument* mOverrideStyle{};
@@ -232,13 +440,89 @@ private:
 
     // Temporary resources. Will get cleaned-up after parsing.
     std::map<std::string, GradientImpl> mGradients;
+    // mGradients with defaults resolved against mViewBox, referenced by paints.
+    std::map<std::string, std::shared_ptr<const GradientImpl>> mGradientPaints;
     std::map<std::string, XMLNode*> mResourceIDs;
     std::map<std::string, std::shared_ptr<ClippingPath>> mClippingPaths;
-    std::stack<std::shared_ptr<Group>> mGroupStack;
-
-    // Render tree created during parsing.
-    std::shared_ptr<Group> mGroup;
-    std::map<std::string, std::shared_ptr<Element>> mIdToElementToMap;
+    std::stack<NodeRef> mGroupStack;
+    // XML fragments parsed by ParseFragment() that resources in mResourceIDs point into.
+    std::vector<std::unique_ptr<XMLDocument>> mFragments;
+    bool mHasNewResource{};
+    // Outlines of path, polygon and polyline elements parsed ahead of the traversal
+    // by PreparsePaths(). Indexed by the element they belong to.
+    std::vector<PathRecorder> mPreparsedPaths;
+    std::unordered_map<const XMLNode*, size_t> mPreparsedPathIndex;
+    ParseBudget mBudget;
+    // Content of the <use> elements that are instantiated at the moment, outermost first.
+    std::vector<const XMLNode*> mUseTargets;
+    // Content referenced by <use> elements with the inherited style it got parsed with
+    // and the work it took, which gets charged to mBudget on every further instantiation.
+    struct UseContent
+    {
+        StyleIndex fillStyle;
+        StyleIndex strokeStyle;
+        std::array<float, 4> viewBox;
+        std::uint32_t content;
+        size_t elementCount;
+        size_t useCount;
+        // Nesting depth of <use> elements inside the content.
+        size_t useDepth;
+    };
+    std::unordered_map<const XMLNode*, std::vector<UseContent>> mUseContents;
+    // Renderer paths created so far by their outlines, grouped by PathRecorder::Hash().
+    // Only used with ParseOptions::deduplicatePaths.
+    std::unordered_map<size_t, std::vector<std::pair<PathRecorder, std::shared_ptr<Path>>>> mSharedPaths;
+    size_t mDeduplicatedPathCount{};
+    // Outlines and matrices of the renderer objects in the render tree. Renderer
+    // objects are opaque, Serialize() saves these instead. Only filled with
+    // ParseOptions::isSerializable.
+    std::unordered_map<const Path*, PathRecorder> mPathRecordings;
+    std::unordered_map<const Transform*, std::array<float, 6>> mTransformMatrices;
+    // Bounds of the outlines of renderer paths. Only filled with ParseOptions::computeBounds.
+    std::unordered_map<const Path*, Box> mPathBounds;
+    // Conservative bounds of the nodes of each render tree in the coordinates of the
+    // root of the tree, and the transform from the content of each instance to the
+    // root. Computed on the first culled rendering. Guarded by mBoundsMutex.
+    struct TreeBounds
+    {
+        std::vector<Box> boxes;
+        std::unordered_map<std::uint32_t, std::array<float, 6>> instanceMatrices;
+    };
+    std::vector<TreeBounds> mTreeBounds;
+    std::mutex mBoundsMutex;
+
+    // Render trees created during parsing. mTrees[0] is the document. The content of
+    // <use> elements and elements built on demand by lazy documents get trees of
+    // their own.
+    std::vector<RenderTree> mTrees;
+    std::vector<std::shared_ptr<Path>> mPaths;
+    std::vector<Image> mImages;
+    InternTable<GraphicStyleImpl, StyleHash, StyleEqual> mGraphicStyles;
+    InternTable<FillStyleImpl, StyleHash, StyleEqual> mFillStyles;
+    InternTable<StrokeStyleImpl, StyleHash, StyleEqual> mStrokeStyles;
+    InternTable<std::set<std::string>, StyleHash, StyleEqual> mClassNames;
+    std::map<std::string, NodeRef> mIdToElementToMap;
+    // Slots of the var() names used by the render tree, see CompileColorMap().
+    std::unordered_map<std::string, std::uint32_t> mVariableSlots;
+    std::vector<std::string> mVariableNames;
+
+    // Decoded images, most recently used first. Guarded by mImageMutex since
+    // rendering may happen on several threads.
+    std::list<std::shared_ptr<ImageSource>> mDecodedImages;
+    size_t mDecodedImageSize{};
+    std::mutex mImageMutex;
+
+    // Scratch storage of finished renderings for the next ones.
+    std::vector<std::unique_ptr<RenderScratch>> mRenderScratch;
+    std::mutex mRenderScratchMutex;
+
+    // Lazy mode: Elements with an id that are not built yet. Resources are parsed
+    // up front and ParseChild() skips them while mIsLazy is set.
+    std::unordered_map<std::string, XMLNode*> mLazyElements;
+    std::atomic<bool> mIsLazy{false};
+    // Serializes building elements of lazy documents with everything that reads the
+    // state building changes. Not needed anymore once mIsLazy is cleared.
+    mutable std::mutex mBuildMutex;
 
 #if DEBUG
     std::string mTitle;
@@ -0,0 +1,124 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace SVGNative
+{
+
+// Elements the parser knows about. All other elements map to kUnknown.
+enum class ElementTag
+{
+    kUnknown,
+    kSVG,
+    kG,
+    kDefs,
+    kImage,
+    kUse,
+    kSymbol,
+    kStyle,
+    kLinearGradient,
+    kRadialGradient,
+    kClipPath,
+    kStop,
+    kRect,
+    kCircle,
+    kEllipse,
+    kLine,
+    kPolygon,
+    kPolyline,
+    kPath
+};
+
+struct ElementNameInfo
+{
+    const char* name;
+    std::size_t length;
+    ElementTag tag;
+};
+
+// Perfect hash over the element names above. Length, first and last character
+// are unique for every name. The multipliers were found by a brute force search
+// for the smallest table without collisions.
+constexpr std::size_t ElementNameHash(const char* name, std::size_t length)
+{
+    return (length + static_cast<unsigned char>(name[0]) * 26 + static_cast<unsigned char>(name[length - 1]) * 22) & 31;
+}
+
+constexpr ElementNameInfo gElementNames[32] = {
+    {"", 0, ElementTag::kUnknown},
+    {"style", 5, ElementTag::kStyle},
+    {"circle", 6, ElementTag::kCircle},
+    {"", 0, ElementTag::kUnknown},
+    {"", 0, ElementTag::kUnknown},
+    {"", 0, ElementTag::kUnknown},
+    {"clipPath", 8, ElementTag::kClipPath},
+    {"", 0, ElementTag::kUnknown},
+    {"", 0, ElementTag::kUnknown},
+    {"", 0, ElementTag::kUnknown},
+    {"line", 4, ElementTag::kLine},
+    {"svg", 3, ElementTag::kSVG},
+    {"", 0, ElementTag::kUnknown},
+    {"", 0, ElementTag::kUnknown},
+    {"defs", 4, ElementTag::kDefs},
+    {"", 0, ElementTag::kUnknown},
+    {"rect", 4, ElementTag::kRect},
+    {"g", 1, ElementTag::kG},
+    {"stop", 4, ElementTag::kStop},
+    {"use", 3, ElementTag::kUse},
+    {"path", 4, ElementTag::kPath},
+    {"", 0, ElementTag::kUnknown},
+    {"polyline", 8, ElementTag::kPolyline},
+    {"ellipse", 7, ElementTag::kEllipse},
+    {"", 0, ElementTag::kUnknown},
+    {"", 0, ElementTag::kUnknown},
+    {"radialGradient", 14, ElementTag::kRadialGradient},
+    {"polygon", 7, ElementTag::kPolygon},
+    {"symbol", 6, ElementTag::kSymbol},
+    {"image", 5, ElementTag::kImage},
+    {"linearGradient", 14, ElementTag::kLinearGradient},
+    {"", 0, ElementTag::kUnknown}
+};
+
+constexpr bool IsSameName(const char* a, const char* b, std::size_t length)
+{
+    return length == 0 || (*a == *b && IsSameName(a + 1, b + 1, length - 1));
+}
+
+constexpr ElementTag MatchElementName(const ElementNameInfo& info, const char* name, std::size_t length)
+{
+    return (info.length == length && IsSameName(info.name, name, length)) ? info.tag : ElementTag::kUnknown;
+}
+
+// Maps an element name of the given length to its tag. The name does not need
+// to be NUL-terminated.
+constexpr ElementTag GetElementTag(const char* name, std::size_t length)
+{
+    return length == 0 ? ElementTag::kUnknown : MatchElementName(gElementNames[ElementNameHash(name, length)], name, length);
+}
+
+constexpr std::size_t NameLength(const char* name) { return *name ? 1 + NameLength(name + 1) : 0; }
+
+constexpr bool IsPerfectHashTable(std::size_t index = 0)
+{
+    return index == 32
+        || ((gElementNames[index].length == NameLength(gElementNames[index].name))
+            && (gElementNames[index].tag == ElementTag::kUnknown
+                || ElementNameHash(gElementNames[index].name, gElementNames[index].length) == index)
+            && IsPerfectHashTable(index + 1));
+}
+
+static_assert(IsPerfectHashTable(), "Every element name must be stored at the slot of its hash.");
+
+} // namespace SVGNative
@@ -0,0 +1,71 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+namespace SVGNative
+{
+
+// Stores every distinct value once and addresses it by index. Hash and Equal are
+// function objects for T. References to stored values stay valid when more values
+// get added.
+template <typename T, typename Hash, typename Equal>
+class InternTable
+{
+public:
+    using Index = std::uint32_t;
+
+    // Returns the index of the stored value equal to value. Adds value if there is none.
+    Index Intern(const T& value)
+    {
+        auto hash = Hash()(value);
+        auto range = mLookup.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (Equal()(mValues[it->second], value))
+                return it->second;
+        }
+
+        auto index = static_cast<Index>(mValues.size());
+        mValues.push_back(value);
+        mLookup.emplace(hash, index);
+        return index;
+    }
+
+    // Adds value without looking for an equal one. Used to restore a table in its
+    // original order.
+    Index Append(const T& value)
+    {
+        auto index = static_cast<Index>(mValues.size());
+        mValues.push_back(value);
+        return index;
+    }
+
+    const T& operator[](Index index) const { return mValues[index]; }
+    std::size_t Size() const { return mValues.size(); }
+
+    // Frees the memory needed to find existing values. Values added afterwards
+    // are not deduplicated against the ones stored before.
+    void ReleaseLookup() { std::unordered_multimap<std::size_t, Index>().swap(mLookup); }
+
+private:
+    std::deque<T> mValues;
+    std::unordered_multimap<std::size_t, Index> mLookup;
+};
+
+} // namespace SVGNative
@@ -35,6 +35,7 @@ governing permissions and limitations under the License.
 #include "StringSVGRenderer.h"
 #endif
 
+#include <atomic>
 #include <map>
 #include <memory>
 
@@ -42,9 +43,14 @@ template <typename T>
 void ignore(T &&)
 { }
 
+// Changes whenever any color map gets created or modified. Contexts compare it to
+// know when their compiled color map is out of date.
+static std::atomic<unsigned long long> gColorMapRevision{};
+
 struct svg_native_color_map_t_
 {
     SVGNative::ColorMap mColorMap;
+    unsigned long long mRevision{++gColorMapRevision};
 };
 
 struct svg_native_t_
@@ -53,6 +59,9 @@ struct svg_native_t_
     std::unique_ptr<SVGNative::SVGDocument> mDocument;
     svg_native_renderer_type_t mRendererType{SVG_RENDERER_UNKNOWN};
     svg_native_color_map_t* mColorMap{};
+    // mColorMap resolved against mDocument. Revision 0 means not compiled yet.
+    SVGNative::CompiledColorMap mCompiledColorMap;
+    unsigned long long mCompiledRevision{};
 };
 
 svg_native_color_map_t* svg_native_color_map_create()
@@ -65,6 +74,7 @@ void svg_native_color_map_add(svg_native_color_map_t* color_map, const char* col
     if (auto _color_map = dynamic_cast<svg_native_color_map_t_*>(color_map))
     {
         _color_map->mColorMap.insert({color_key, {red, green, blue, alpha}});
+        _color_map->mRevision = ++gColorMapRevision;
     }
 }
 
@@ -76,7 +86,7 @@ void svg_native_color_map_destroy(svg_native_color_map_t* color_map)
     }
 }
 
-svg_native_t* svg_native_create(svg_native_renderer_type_t renderer_type, const char* document_string)
+static svg_native_t_* svg_native_create_context(svg_native_renderer_type_t renderer_type)
 {
     auto sn = new svg_native_t_;
 
@@ -127,6 +137,18 @@ svg_native_t* svg_native_create(svg_native_renderer_type_t renderer_type, const
     }
 
     if (!sn->mRenderer)
+    {
+        delete sn;
+        return nullptr;
+    }
+
+    return sn;
+}
+
+svg_native_t* svg_native_create(svg_native_renderer_type_t renderer_type, const char* document_string)
+{
+    auto sn = svg_native_create_context(renderer_type);
+    if (!sn)
         return nullptr;
 
     sn->mDocument = SVGNative::SVGDocument::CreateSVGDocument(document_string, sn->mRenderer);
@@ -134,12 +156,39 @@ svg_native_t* svg_native_create(svg_native_renderer_type_t renderer_type, const
     return reinterpret_cast<svg_native_t*>(sn);
 }
 
+svg_native_t* svg_native_create_from_file(svg_native_renderer_type_t renderer_type, const char* path)
+{
+    auto sn = svg_native_create_context(renderer_type);
+    if (!sn)
+        return nullptr;
+
+    sn->mDocument = SVGNative::SVGDocument::CreateSVGDocumentFromFile(path, sn->mRenderer);
+    if (!sn->mDocument)
+    {
+        delete sn;
+        return nullptr;
+    }
+
+    return reinterpret_cast<svg_native_t*>(sn);
+}
+
 void svg_native_set_color_map(svg_native_t* sn, svg_native_color_map_t* color_map)
 {
     if (auto _sn = dynamic_cast<svg_native_t_*>(sn))
     {
         _sn->mColorMap = color_map;
+        _sn->mCompiledRevision = 0;
+    }
+}
+
+static const SVGNative::CompiledColorMap& svg_native_compiled_color_map(svg_native_t_& sn)
+{
+    if (sn.mCompiledRevision != sn.mColorMap->mRevision)
+    {
+        sn.mCompiledColorMap = sn.mDocument->CompileColorMap(sn.mColorMap->mColorMap);
+        sn.mCompiledRevision = sn.mColorMap->mRevision;
     }
+    return sn.mCompiledColorMap;
 }
 
 void svg_native_set_renderer(svg_native_t* sn, svg_native_renderer_t* renderer)
@@ -203,7 +252,7 @@ void svg_native_set_renderer(svg_native_t* sn, svg_native_renderer_t* renderer)
 float svg_native_canvas_width(svg_native_t* sn)
 {
     auto _sn = dynamic_cast<svg_native_t_*>(sn);
-    if (!_sn)
+    if (!_sn || !_sn->mDocument)
         return 0;
     return _sn->mDocument->Width();
 }
@@ -211,7 +260,7 @@ float svg_native_canvas_width(svg_native_t* sn)
 float svg_native_canvas_height(svg_native_t* sn)
 {
     auto _sn = dynamic_cast<svg_native_t_*>(sn);
-    if (!_sn)
+    if (!_sn || !_sn->mDocument)
         return 0;
     return _sn->mDocument->Height();
 }
@@ -219,11 +268,11 @@ float svg_native_canvas_height(svg_native_t* sn)
 void svg_native_render(svg_native_t* sn)
 {
     auto _sn = dynamic_cast<svg_native_t_*>(sn);
-    if (!_sn)
+    if (!_sn || !_sn->mDocument)
         return;
     
     if (_sn->mColorMap)
-        _sn->mDocument->Render(_sn->mColorMap->mColorMap);
+        _sn->mDocument->Render(svg_native_compiled_color_map(*_sn));
     else
         _sn->mDocument->Render();
 }
@@ -231,11 +280,11 @@ void svg_native_render(svg_native_t* sn)
 void svg_native_render_size(svg_native_t* sn, float width, float height)
 {
     auto _sn = dynamic_cast<svg_native_t_*>(sn);
-    if (!_sn)
+    if (!_sn || !_sn->mDocument)
         return;
     
     if (_sn->mColorMap)
-        _sn->mDocument->Render(_sn->mColorMap->mColorMap, width, height);
+        _sn->mDocument->Render(svg_native_compiled_color_map(*_sn), width, height);
     else
         _sn->mDocument->Render(width, height);
 }
@@ -0,0 +1,199 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "SVGParseBudget.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SVGNative
+{
+
+void ParseBudget::Start()
+{
+    if (mLimits.timeLimit)
+        mDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(mLimits.timeLimit);
+}
+
+void ParseBudget::CheckTime() const
+{
+    if (mLimits.timeLimit && std::chrono::steady_clock::now() > mDeadline)
+        throw ParseLimitError(ParseResult::kTimeLimit);
+}
+
+void ParseBudget::CheckDepth(const char* text, size_t depth) const
+{
+    if (!mLimits.maxDepth)
+        return;
+
+    // Only tells tags apart from comments, CDATA sections, processing instructions and
+    // DOCTYPE declarations. Malformed XML gets rejected by the parser afterwards.
+    auto skipPast = [](const char* p, const char* end) {
+        p = std::strstr(p, end);
+        return p ? p + std::strlen(end) : nullptr;
+    };
+    for (auto p = std::strchr(text, '<'); p != nullptr; p = std::strchr(p, '<'))
+    {
+        ++p;
+        if (*p == '/')
+        {
+            if (depth)
+                --depth;
+            continue;
+        }
+        if (*p == '?')
+            p = skipPast(p, "?>");
+        else if (std::strncmp(p, "!--", 3) == 0)
+            p = skipPast(p, "-->");
+        else if (std::strncmp(p, "![CDATA[", 8) == 0)
+            p = skipPast(p, "]]>");
+        else if (*p == '!')
+        {
+            // DOCTYPE with an optional internal subset in brackets.
+            size_t brackets = 0;
+            for (; *p && (*p != '>' || brackets); ++p)
+            {
+                if (*p == '[')
+                    ++brackets;
+                else if (*p == ']' && brackets)
+                    --brackets;
+            }
+        }
+        else
+        {
+            // Start tag. Attribute values may contain '>'.
+            char quote = 0;
+            for (; *p && (*p != '>' || quote); ++p)
+            {
+                if (quote)
+                    quote = *p == quote ? 0 : quote;
+                else if (*p == '"' || *p == '\'')
+                    quote = *p;
+            }
+            if (*p && depth + 1 > mLimits.maxDepth)
+                throw ParseLimitError(ParseResult::kDepthLimit);
+            if (*p && p[-1] != '/')
+                ++depth;
+        }
+        if (!p || !*p)
+            return;
+    }
+}
+
+void ParseBudget::AddElement()
+{
+    if (++mElementCount > mLimits.maxElements && mLimits.maxElements)
+        throw ParseLimitError(ParseResult::kElementLimit);
+    CheckTime();
+}
+
+void ParseBudget::AddUse(size_t depth)
+{
+    if (mLimits.maxUseDepth && depth > mLimits.maxUseDepth)
+        throw ParseLimitError(ParseResult::kUseDepthLimit);
+    if (++mUseCount > mLimits.maxUseExpansions && mLimits.maxUseExpansions)
+        throw ParseLimitError(ParseResult::kUseExpansionLimit);
+    mUseDepth = std::max(mUseDepth, depth);
+}
+
+void ParseBudget::AddReusedContent(size_t elementCount, size_t useCount, size_t useDepth)
+{
+    // Same order of checks as parsing the content again would hit them.
+    if (mLimits.maxUseDepth && useDepth > mLimits.maxUseDepth)
+        throw ParseLimitError(ParseResult::kUseDepthLimit);
+    mElementCount += elementCount;
+    if (mLimits.maxElements && mElementCount > mLimits.maxElements)
+        throw ParseLimitError(ParseResult::kElementLimit);
+    mUseCount += useCount;
+    if (mLimits.maxUseExpansions && mUseCount > mLimits.maxUseExpansions)
+        throw ParseLimitError(ParseResult::kUseExpansionLimit);
+    mUseDepth = std::max(mUseDepth, useDepth);
+    CheckTime();
+}
+
+void ParseBudget::AddPathSegments(size_t count)
+{
+    if (mLimits.maxPathSegments && mPathSegmentCount.fetch_add(count) + count > mLimits.maxPathSegments)
+        throw ParseLimitError(ParseResult::kPathSegmentLimit);
+    CheckTime();
+}
+
+void ParseBudget::AddImage(size_t size)
+{
+    mImageSize += size;
+    if (mLimits.maxImageSize && mImageSize > mLimits.maxImageSize)
+        throw ParseLimitError(ParseResult::kImageSizeLimit);
+}
+
+void BudgetedPath::Rect(float x, float y, float width, float height)
+{
+    mPath.Rect(x, y, width, height);
+    Count();
+}
+
+void BudgetedPath::RoundedRect(float x, float y, float width, float height, float cornerRadiusX, float cornerRadiusY)
+{
+    mPath.RoundedRect(x, y, width, height, cornerRadiusX, cornerRadiusY);
+    Count();
+}
+
+void BudgetedPath::Ellipse(float cx, float cy, float rx, float ry)
+{
+    mPath.Ellipse(cx, cy, rx, ry);
+    Count();
+}
+
+void BudgetedPath::MoveTo(float x, float y)
+{
+    mPath.MoveTo(x, y);
+    Count();
+}
+
+void BudgetedPath::LineTo(float x, float y)
+{
+    mPath.LineTo(x, y);
+    Count();
+}
+
+void BudgetedPath::CurveTo(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    mPath.CurveTo(x1, y1, x2, y2, x3, y3);
+    Count();
+}
+
+void BudgetedPath::CurveToV(float x2, float y2, float x3, float y3)
+{
+    mPath.CurveToV(x2, y2, x3, y3);
+    Count();
+}
+
+void BudgetedPath::ClosePath()
+{
+    mPath.ClosePath();
+    Count();
+}
+
+void BudgetedPath::Finish()
+{
+    mBudget.AddPathSegments(mPendingCount);
+    mPendingCount = 0;
+}
+
+void BudgetedPath::Count()
+{
+    // Report in batches to keep the shared counter and the clock out of the inner loop.
+    constexpr size_t kBatchSize = 1024;
+    if (++mPendingCount == kBatchSize)
+        Finish();
+}
+
+} // namespace SVGNative
@@ -0,0 +1,120 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+
+#pragma once
+
+#include "SVGDocument.h"
+#include "SVGRenderer.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+namespace SVGNative
+{
+
+// Thrown when parsing exceeds one of the ParseLimits.
+class ParseLimitError : public std::runtime_error
+{
+public:
+    explicit ParseLimitError(ParseResult result)
+        : std::runtime_error("Parse limit exceeded")
+        , mResult{result}
+    {
+    }
+
+    ParseResult Result() const { return mResult; }
+
+private:
+    ParseResult mResult;
+};
+
+// Keeps track of the work spent on a document and throws ParseLimitError once a
+// limit is exceeded. AddPathSegments() and CheckTime() may get called from path
+// parsing threads, everything else only from the parsing thread.
+class ParseBudget
+{
+public:
+    explicit ParseBudget(const ParseLimits& limits)
+        : mLimits(limits)
+    {
+    }
+
+    // Starts the time limit for the next parsing pass.
+    void Start();
+    void CheckTime() const;
+    // Checks the nesting depth of the elements in the NUL-terminated XML text before
+    // it gets parsed. The text starts at the given depth.
+    void CheckDepth(const char* text, size_t depth = 0) const;
+
+    void AddElement();
+    // Counts an instantiation of a <use> element at the given nesting depth.
+    void AddUse(size_t depth);
+    // Counts another instantiation of <use> content that was parsed before. The content
+    // had elementCount elements and useCount <use> elements nested up to useDepth.
+    void AddReusedContent(size_t elementCount, size_t useCount, size_t useDepth);
+    void AddPathSegments(size_t count);
+    void AddImage(size_t size);
+
+    // False if parsing outlines does not need to be tracked.
+    bool LimitsPaths() const { return mLimits.maxPathSegments || mLimits.timeLimit; }
+
+    size_t ElementCount() const { return mElementCount; }
+    size_t UseCount() const { return mUseCount; }
+    // Deepest nesting of <use> elements counted since the last SetUseDepth().
+    size_t UseDepth() const { return mUseDepth; }
+    void SetUseDepth(size_t depth) { mUseDepth = depth; }
+
+private:
+    ParseLimits mLimits;
+    std::chrono::steady_clock::time_point mDeadline;
+    size_t mElementCount{};
+    size_t mUseCount{};
+    size_t mUseDepth{};
+    std::atomic<size_t> mPathSegmentCount{0};
+    size_t mImageSize{};
+};
+
+// Forwards the outline to another Path and counts the segments against a budget.
+// Call Finish() after the last segment.
+class BudgetedPath final : public Path
+{
+public:
+    BudgetedPath(Path& path, ParseBudget& budget)
+        : mPath(path)
+        , mBudget(budget)
+    {
+    }
+
+    void Rect(float x, float y, float width, float height) override;
+    void RoundedRect(float x, float y, float width, float height, float cornerRadiusX, float cornerRadiusY) override;
+    void Ellipse(float cx, float cy, float rx, float ry) override;
+
+    void MoveTo(float x, float y) override;
+    void LineTo(float x, float y) override;
+    void CurveTo(float x1, float y1, float x2, float y2, float x3, float y3) override;
+    void CurveToV(float x2, float y2, float x3, float y3) override;
+    void ClosePath() override;
+
+    void Finish();
+
+private:
+    void Count();
+
+    Path& mPath;
+    ParseBudget& mBudget;
+    // Segments not reported to mBudget yet.
+    size_t mPendingCount{};
+};
+
+} // namespace SVGNative
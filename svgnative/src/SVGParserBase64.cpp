@@ -0,0 +1,222 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "SVGParserBase64.h"
+#include "SVGRenderer.h"
+
+#include <cstdint>
+#include <cstring>
+
+// Targets with SSSE3 always use it. Other x86 builds with GCC or Clang compile the SSSE3
+// path for SSSE3 only and use it if the CPU supports it.
+#if defined(__SSSE3__)
+#define SVG_BASE64_SSSE3
+#define SVG_TARGET_SSSE3
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SVG_BASE64_SSSE3
+#define SVG_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+#ifdef SVG_BASE64_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace SVGNative
+{
+
+// Value of each base64 digit, -1 for all other characters.
+static const std::int8_t gBase64Values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static bool IsBase64Whitespace(unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+#ifdef SVG_BASE64_SSSE3
+// Decodes 16 characters to 12 bytes. Returns false without writing anything if the
+// block contains other characters than base64 digits, e.g. whitespace or padding.
+// See http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html for the approach.
+SVG_TARGET_SSSE3 static bool DecodeBlock(const unsigned char* in, unsigned char* out)
+{
+    const __m128i lutLow = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHigh = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+    auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    auto highNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), nibbleMask);
+    auto lowNibbles = _mm_and_si128(chars, nibbleMask);
+
+    // lutHigh maps the high nibble to a character range, lutLow has the ranges in which
+    // the low nibble does not make a digit.
+    auto invalid = _mm_and_si128(_mm_shuffle_epi8(lutLow, lowNibbles), _mm_shuffle_epi8(lutHigh, highNibbles));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())))
+        return false;
+
+    // '/' shares the high nibble with '+' but needs a different offset.
+    auto isSlash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+    auto roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(isSlash, highNibbles));
+    auto values = _mm_add_epi8(chars, roll);
+
+    // Merge 4 6-bit values to 24 bits per 32-bit lane, then reorder to big endian.
+    auto pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    auto quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    auto bytes = _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+    auto last = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+    memcpy(out + 8, &last, 4);
+    return true;
+}
+
+// Decodes blocks of 16 characters until one has other characters than base64 digits
+// or less than 16 characters are left.
+SVG_TARGET_SSSE3 static void DecodeBlocks(const unsigned char*& in, const unsigned char* end, unsigned char*& out)
+{
+    while (end - in >= 16 && DecodeBlock(in, out))
+    {
+        in += 16;
+        out += 12;
+    }
+}
+#endif
+
+bool IsBase64DecoderAvailable(Base64Decoder decoder)
+{
+    switch (decoder)
+    {
+    case Base64Decoder::kScalar:
+        return true;
+    case Base64Decoder::kSSSE3:
+#if defined(__SSSE3__)
+        return true;
+#elif defined(SVG_BASE64_SSSE3)
+        return __builtin_cpu_supports("ssse3");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+size_t Base64DecodedSize(size_t length)
+{
+    return (length + 3) / 4 * 3;
+}
+
+bool Base64Decode(const char* base64, size_t length, unsigned char* output, size_t& outputLength)
+{
+    static const auto decoder
+        = IsBase64DecoderAvailable(Base64Decoder::kSSSE3) ? Base64Decoder::kSSSE3 : Base64Decoder::kScalar;
+    return Base64Decode(decoder, base64, length, output, outputLength);
+}
+
+bool Base64Decode(Base64Decoder decoder, const char* base64, size_t length, unsigned char* output, size_t& outputLength)
+{
+#ifndef SVG_BASE64_SSSE3
+    (void)decoder;
+#endif
+    auto in = reinterpret_cast<const unsigned char*>(base64);
+    auto end = in + length;
+    auto out = output;
+
+    std::uint32_t value{};
+    int count{};
+    while (in != end)
+    {
+        if (count == 0)
+        {
+#ifdef SVG_BASE64_SSSE3
+            if (decoder == Base64Decoder::kSSSE3)
+                DecodeBlocks(in, end, out);
+#endif
+            while (end - in >= 4)
+            {
+                auto a = gBase64Values[in[0]];
+                auto b = gBase64Values[in[1]];
+                auto c = gBase64Values[in[2]];
+                auto d = gBase64Values[in[3]];
+                if ((a | b | c | d) < 0)
+                    break;
+                value = (static_cast<std::uint32_t>(a) << 18) | (static_cast<std::uint32_t>(b) << 12)
+                    | (static_cast<std::uint32_t>(c) << 6) | static_cast<std::uint32_t>(d);
+                out[0] = static_cast<unsigned char>(value >> 16);
+                out[1] = static_cast<unsigned char>(value >> 8);
+                out[2] = static_cast<unsigned char>(value);
+                in += 4;
+                out += 3;
+            }
+            if (in == end)
+                break;
+        }
+
+        // Whitespace, padding or the end of the data got in the way of the fast paths.
+        auto c = *in++;
+        if (IsBase64Whitespace(c))
+            continue;
+        if (c == '=')
+        {
+            for (; in != end; ++in)
+            {
+                if (*in != '=' && !IsBase64Whitespace(*in))
+                    return false;
+            }
+            break;
+        }
+        auto digit = gBase64Values[c];
+        if (digit < 0)
+            return false;
+        value = (value << 6) | static_cast<std::uint32_t>(digit);
+        if (++count == 4)
+        {
+            out[0] = static_cast<unsigned char>(value >> 16);
+            out[1] = static_cast<unsigned char>(value >> 8);
+            out[2] = static_cast<unsigned char>(value);
+            out += 3;
+            value = 0;
+            count = 0;
+        }
+    }
+
+    // A trailing group of 2 or 3 digits encodes 1 or 2 bytes.
+    if (count == 1)
+        return false;
+    if (count == 2)
+        *out++ = static_cast<unsigned char>(value >> 4);
+    else if (count == 3)
+    {
+        *out++ = static_cast<unsigned char>(value >> 10);
+        *out++ = static_cast<unsigned char>(value >> 2);
+    }
+
+    outputLength = static_cast<size_t>(out - output);
+    return true;
+}
+
+} // namespace SVGNative
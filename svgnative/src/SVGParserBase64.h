@@ -0,0 +1,37 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include "Config.h"
+
+#include <cstddef>
+
+namespace SVGNative
+{
+
+// Implementations behind Base64Decode(). All of them give the same result for the
+// same input. Base64Decode() picks the fastest one the CPU supports.
+enum class Base64Decoder
+{
+    kScalar,
+    kSSSE3
+};
+
+// True if decoder was compiled in and the CPU supports it.
+SVG_IMP_EXP bool IsBase64DecoderAvailable(Base64Decoder decoder);
+
+// Base64Decode() with the given implementation. decoder must be available.
+SVG_IMP_EXP bool Base64Decode(
+    Base64Decoder decoder, const char* base64, size_t length, unsigned char* output, size_t& outputLength);
+
+} // namespace SVGNative
@@ -0,0 +1,149 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+
+#include "SVGRenderer.h"
+
+#include <cstdint>
+#include <string>
+
+namespace SVGNative
+{
+
+static int Base64Value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+')
+        return 62;
+    if (c == '/')
+        return 63;
+    return -1;
+}
+
+// Decodes count bytes starting at byte offset of the decoded data. Every group of
+// 4 characters encodes 3 bytes, so only the groups covering the range get decoded.
+// base64 must not contain whitespace.
+static bool ReadBytes(const std::string& base64, size_t offset, size_t count, std::uint8_t* bytes)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto index = offset + i;
+        auto group = index / 3 * 4;
+        if (group + 4 > base64.size())
+            return false;
+
+        std::uint32_t value{};
+        for (size_t j = 0; j < 4; ++j)
+        {
+            auto digit = Base64Value(base64[group + j]);
+            // Padding may only cover bytes that are not requested.
+            if (digit < 0)
+            {
+                if (base64[group + j] != '=' || j <= index % 3 + 1)
+                    return false;
+                digit = 0;
+            }
+            value = (value << 6) | static_cast<std::uint32_t>(digit);
+        }
+        bytes[i] = static_cast<std::uint8_t>(value >> (16 - 8 * (index % 3)));
+    }
+    return true;
+}
+
+static std::uint32_t ReadBigEndian(const std::uint8_t* bytes, size_t count)
+{
+    std::uint32_t value{};
+    for (size_t i = 0; i < count; ++i)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static bool ReadPNGSize(const std::string& base64, float& width, float& height)
+{
+    // Signature followed by the IHDR chunk with width and height.
+    static const std::uint8_t kSignature[16] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0, 0, 0, 13, 'I', 'H', 'D', 'R'};
+    std::uint8_t header[24];
+    if (!ReadBytes(base64, 0, sizeof(header), header))
+        return false;
+    for (size_t i = 0; i < sizeof(kSignature); ++i)
+    {
+        if (header[i] != kSignature[i])
+            return false;
+    }
+
+    width = static_cast<float>(ReadBigEndian(header + 16, 4));
+    height = static_cast<float>(ReadBigEndian(header + 20, 4));
+    return true;
+}
+
+static bool ReadJPEGSize(const std::string& base64, float& width, float& height)
+{
+    std::uint8_t marker[2];
+    if (!ReadBytes(base64, 0, 2, marker) || marker[0] != 0xFF || marker[1] != 0xD8)
+        return false;
+
+    // Walk the marker segments up to the first start of frame.
+    size_t offset = 2;
+    for (;;)
+    {
+        if (!ReadBytes(base64, offset, 2, marker) || marker[0] != 0xFF)
+            return false;
+        auto type = marker[1];
+        if (type == 0xFF)
+        {
+            // Fill byte.
+            ++offset;
+            continue;
+        }
+        offset += 2;
+        // Markers without payload.
+        if (type == 0x01 || (type >= 0xD0 && type <= 0xD8))
+            continue;
+        // Start of scan or end of image without a frame header.
+        if (type == 0xD9 || type == 0xDA)
+            return false;
+
+        std::uint8_t segment[7];
+        if (!ReadBytes(base64, offset, 2, segment))
+            return false;
+        auto length = ReadBigEndian(segment, 2);
+        if (length < 2)
+            return false;
+
+        // SOF0 to SOF15 except DHT, JPG and DAC.
+        if (type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC)
+        {
+            if (length < 7 || !ReadBytes(base64, offset, 7, segment))
+                return false;
+            height = static_cast<float>(ReadBigEndian(segment + 3, 2));
+            width = static_cast<float>(ReadBigEndian(segment + 5, 2));
+            return true;
+        }
+        offset += length;
+    }
+}
+
+// Reads the intrinsic size of a PNG or JPEG image from its header without decoding
+// the image. The actual format is detected from the data. Returns false for other
+// formats and for damaged headers.
+bool ReadImageSize(const std::string& base64, float& width, float& height);
+bool ReadImageSize(const std::string& base64, float& width, float& height)
+{
+    return ReadPNGSize(base64, width, height) || ReadJPEGSize(base64, width, height);
+}
+
+} // namespace SVGNative
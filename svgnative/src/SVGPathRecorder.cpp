@@ -0,0 +1,119 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+
+#include "SVGPathRecorder.h"
+
+#include <cstring>
+
+namespace SVGNative
+{
+
+void PathRecorder::Add(Command command, std::initializer_list<float> values)
+{
+    mCommands.push_back(command);
+    // Adding 0 turns -0 into 0 so that both compare and hash the same.
+    for (auto value : values)
+        mValues.push_back(value + 0.0f);
+}
+
+void PathRecorder::Rect(float x, float y, float width, float height) { Add(Command::kRect, {x, y, width, height}); }
+
+void PathRecorder::RoundedRect(float x, float y, float width, float height, float cornerRadiusX, float cornerRadiusY)
+{
+    Add(Command::kRoundedRect, {x, y, width, height, cornerRadiusX, cornerRadiusY});
+}
+
+void PathRecorder::Ellipse(float cx, float cy, float rx, float ry) { Add(Command::kEllipse, {cx, cy, rx, ry}); }
+
+void PathRecorder::MoveTo(float x, float y) { Add(Command::kMoveTo, {x, y}); }
+
+void PathRecorder::LineTo(float x, float y) { Add(Command::kLineTo, {x, y}); }
+
+void PathRecorder::CurveTo(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    Add(Command::kCurveTo, {x1, y1, x2, y2, x3, y3});
+}
+
+void PathRecorder::CurveToV(float x2, float y2, float x3, float y3) { Add(Command::kCurveToV, {x2, y2, x3, y3}); }
+
+void PathRecorder::ClosePath() { mCommands.push_back(Command::kClosePath); }
+
+void PathRecorder::Replay(Path& path) const
+{
+    const float* v = mValues.data();
+    for (auto command : mCommands)
+    {
+        switch (command)
+        {
+        case Command::kRect:
+            path.Rect(v[0], v[1], v[2], v[3]);
+            v += 4;
+            break;
+        case Command::kRoundedRect:
+            path.RoundedRect(v[0], v[1], v[2], v[3], v[4], v[5]);
+            v += 6;
+            break;
+        case Command::kEllipse:
+            path.Ellipse(v[0], v[1], v[2], v[3]);
+            v += 4;
+            break;
+        case Command::kMoveTo:
+            path.MoveTo(v[0], v[1]);
+            v += 2;
+            break;
+        case Command::kLineTo:
+            path.LineTo(v[0], v[1]);
+            v += 2;
+            break;
+        case Command::kCurveTo:
+            path.CurveTo(v[0], v[1], v[2], v[3], v[4], v[5]);
+            v += 6;
+            break;
+        case Command::kCurveToV:
+            path.CurveToV(v[0], v[1], v[2], v[3]);
+            v += 4;
+            break;
+        case Command::kClosePath:
+            path.ClosePath();
+            break;
+        }
+    }
+}
+
+size_t PathRecorder::Hash() const
+{
+    // FNV-1a over the commands and the bit patterns of the values.
+    std::uint64_t hash{14695981039346656037ull};
+    auto add = [&hash](std::uint32_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    for (auto command : mCommands)
+        add(static_cast<std::uint32_t>(command));
+    for (auto value : mValues)
+    {
+        std::uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        add(bits);
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool PathRecorder::operator==(const PathRecorder& other) const
+{
+    // Compare bit patterns to stay consistent with Hash().
+    return mCommands == other.mCommands && mValues.size() == other.mValues.size()
+        && (mValues.empty() || memcmp(mValues.data(), other.mValues.data(), mValues.size() * sizeof(float)) == 0);
+}
+
+} // namespace SVGNative
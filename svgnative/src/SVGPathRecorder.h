@@ -0,0 +1,68 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+
+#pragma once
+
+#include "SVGRenderer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace SVGNative
+{
+
+// Renderer independent Path that records all drawing commands. Recordings may
+// get created on any thread and replayed into a renderer Path later.
+class PathRecorder final : public Path
+{
+public:
+    void Rect(float x, float y, float width, float height) override;
+    void RoundedRect(float x, float y, float width, float height, float cornerRadiusX, float cornerRadiusY) override;
+    void Ellipse(float cx, float cy, float rx, float ry) override;
+
+    void MoveTo(float x, float y) override;
+    void LineTo(float x, float y) override;
+    void CurveTo(float x1, float y1, float x2, float y2, float x3, float y3) override;
+    void CurveToV(float x2, float y2, float x3, float y3) override;
+    void ClosePath() override;
+
+    // Issues the recorded commands in the same order on path.
+    void Replay(Path& path) const;
+
+    // Hash of the command stream. Equal recordings have equal hashes.
+    size_t Hash() const;
+    // True if both recordings issue exactly the same commands.
+    bool operator==(const PathRecorder& other) const;
+
+private:
+    enum class Command : std::uint8_t
+    {
+        kRect,
+        kRoundedRect,
+        kEllipse,
+        kMoveTo,
+        kLineTo,
+        kCurveTo,
+        kCurveToV,
+        kClosePath
+    };
+
+    void Add(Command command, std::initializer_list<float> values);
+
+    std::vector<Command> mCommands;
+    std::vector<float> mValues;
+};
+
+} // namespace SVGNative
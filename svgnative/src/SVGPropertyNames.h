@@ -0,0 +1,166 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#pragma once
+
+#include "SVGElementNames.h"
+
+#include <array>
+#include <cstddef>
+
+namespace SVGNative
+{
+
+// Presentation attributes and CSS properties the parser knows about. The
+// inherited properties come first, those stored in FillStyleImpl before those
+// stored in StrokeStyleImpl. kUnknown doubles as number of properties.
+enum class PropertyTag
+{
+    kColor,
+    kClipRule,
+    kFill,
+    kFillRule,
+    kFillOpacity,
+    kVisibility,
+    kStroke,
+    kStrokeDasharray,
+    kStrokeDashoffset,
+    kStrokeLinecap,
+    kStrokeLinejoin,
+    kStrokeMiterlimit,
+    kStrokeOpacity,
+    kStrokeWidth,
+    kClipPath,
+    kDisplay,
+    kOpacity,
+    kStopOpacity,
+    kStopColor,
+    kTransform,
+    kUnknown
+};
+
+constexpr std::size_t kPropertyCount = static_cast<std::size_t>(PropertyTag::kUnknown);
+
+struct PropertyNameInfo
+{
+    const char* name;
+    std::size_t length;
+    PropertyTag tag;
+};
+
+// Perfect hash over the property names above. The multipliers were found by a
+// brute force search for the smallest table without collisions. All names have
+// at least 2 characters.
+constexpr std::size_t PropertyNameHash(const char* name, std::size_t length)
+{
+    return (length + static_cast<unsigned char>(name[0]) * 3 + static_cast<unsigned char>(name[length - 1]) * 7
+        + static_cast<unsigned char>(name[length - 2]) * 18) & 31;
+}
+
+constexpr PropertyNameInfo gPropertyNames[32] = {
+    {"", 0, PropertyTag::kUnknown},
+    {"", 0, PropertyTag::kUnknown},
+    {"fill", 4, PropertyTag::kFill},
+    {"visibility", 10, PropertyTag::kVisibility},
+    {"transform", 9, PropertyTag::kTransform},
+    {"stroke-width", 12, PropertyTag::kStrokeWidth},
+    {"", 0, PropertyTag::kUnknown},
+    {"", 0, PropertyTag::kUnknown},
+    {"stroke", 6, PropertyTag::kStroke},
+    {"stroke-linecap", 14, PropertyTag::kStrokeLinecap},
+    {"stroke-dasharray", 16, PropertyTag::kStrokeDasharray},
+    {"opacity", 7, PropertyTag::kOpacity},
+    {"stroke-linejoin", 15, PropertyTag::kStrokeLinejoin},
+    {"clip-rule", 9, PropertyTag::kClipRule},
+    {"", 0, PropertyTag::kUnknown},
+    {"stop-color", 10, PropertyTag::kStopColor},
+    {"stroke-dashoffset", 17, PropertyTag::kStrokeDashoffset},
+    {"", 0, PropertyTag::kUnknown},
+    {"clip-path", 9, PropertyTag::kClipPath},
+    {"", 0, PropertyTag::kUnknown},
+    {"display", 7, PropertyTag::kDisplay},
+    {"fill-opacity", 12, PropertyTag::kFillOpacity},
+    {"fill-rule", 9, PropertyTag::kFillRule},
+    {"", 0, PropertyTag::kUnknown},
+    {"stroke-miterlimit", 17, PropertyTag::kStrokeMiterlimit},
+    {"", 0, PropertyTag::kUnknown},
+    {"color", 5, PropertyTag::kColor},
+    {"", 0, PropertyTag::kUnknown},
+    {"stop-opacity", 12, PropertyTag::kStopOpacity},
+    {"", 0, PropertyTag::kUnknown},
+    {"stroke-opacity", 14, PropertyTag::kStrokeOpacity},
+    {"", 0, PropertyTag::kUnknown}
+};
+
+constexpr PropertyTag MatchPropertyName(const PropertyNameInfo& info, const char* name, std::size_t length)
+{
+    return (info.length == length && IsSameName(info.name, name, length)) ? info.tag : PropertyTag::kUnknown;
+}
+
+// Maps a property name of the given length to its tag. The name does not need
+// to be NUL-terminated.
+constexpr PropertyTag GetPropertyTag(const char* name, std::size_t length)
+{
+    return length < 2 ? PropertyTag::kUnknown : MatchPropertyName(gPropertyNames[PropertyNameHash(name, length)], name, length);
+}
+
+constexpr bool IsPerfectPropertyHashTable(std::size_t index = 0)
+{
+    return index == 32
+        || ((gPropertyNames[index].length == NameLength(gPropertyNames[index].name))
+            && (gPropertyNames[index].tag == PropertyTag::kUnknown
+                || PropertyNameHash(gPropertyNames[index].name, gPropertyNames[index].length) == index)
+            && IsPerfectPropertyHashTable(index + 1));
+}
+
+static_assert(IsPerfectPropertyHashTable(), "Every property name must be stored at the slot of its hash.");
+
+// Unparsed value of a property. The value points into the XML document or into
+// the CSS property set it was read from. value is nullptr if the property is
+// not set.
+struct PropertyValue
+{
+    const char* value;
+    std::size_t length;
+};
+
+using PropertySlots = std::array<PropertyValue, kPropertyCount>;
+
+// Stores the value in the slot of the property unless the slot is taken already.
+// The first occurrence of a property wins. Unknown properties are ignored.
+inline void SetProperty(PropertySlots& slots, const char* name, std::size_t nameLength, const char* value, std::size_t valueLength)
+{
+    auto tag = GetPropertyTag(name, nameLength);
+    if (tag == PropertyTag::kUnknown)
+        return;
+    auto& slot = slots[static_cast<std::size_t>(tag)];
+    if (!slot.value)
+        slot = PropertyValue{value, valueLength};
+}
+
+inline const PropertyValue& GetProperty(const PropertySlots& slots, PropertyTag tag)
+{
+    return slots[static_cast<std::size_t>(tag)];
+}
+
+// True if any property from first to last, inclusive, is set.
+inline bool HasProperty(const PropertySlots& slots, PropertyTag first, PropertyTag last)
+{
+    for (auto i = static_cast<std::size_t>(first); i <= static_cast<std::size_t>(last); ++i)
+    {
+        if (slots[i].value)
+            return true;
+    }
+    return false;
+}
+
+} // namespace SVGNative
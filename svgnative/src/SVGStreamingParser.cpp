@@ -0,0 +1,438 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "SVGStreamingParser.h"
+#include "SVGDocument.h"
+#include "SVGDocumentImpl.h"
+#include "SVGParseBudget.h"
+#include "SVGRenderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace SVGNative
+{
+// Elements get parsed one at a time as they arrive. There is nothing to build on
+// demand or to parse ahead on other threads.
+static ParseOptions StreamingOptions(ParseOptions options)
+{
+    options.isLazy = false;
+    options.pathThreadCount = 0;
+    return options;
+}
+
+// Splits the incoming bytes into XML tokens. The root <svg> element and the <g>, <defs>
+// and <symbol> elements are handled on their start and end tags. Every other child
+// element gets buffered until its end tag arrives and is then parsed as a standalone
+// XML fragment. This bounds the buffered text by the size of the largest other element.
+// Children of <defs> are always buffered, since <use> references their XML nodes.
+class SVGStreamingParserImpl
+{
+public:
+    SVGStreamingParserImpl(std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options)
+        : mDocument{new SVGDocumentImpl(renderer, StreamingOptions(options))}
+        , mMaxDepth{options.limits.maxDepth}
+    {
+    }
+
+    bool Feed(const char* data, size_t length);
+    std::unique_ptr<SVGDocumentImpl> Finish(ParseResult& result);
+
+private:
+    enum class TokenType
+    {
+        kIncomplete,
+        kText,
+        kMarkup,
+        kStartTag,
+        kEmptyTag,
+        kEndTag
+    };
+
+    enum class ElementType
+    {
+        kRoot,
+        kGroup,
+        kDefs,
+        kSymbol,
+        kIgnored
+    };
+
+    TokenType NextToken(size_t& end);
+    bool ScanUntil(const char* terminator, size_t from, size_t& end);
+    bool ScanTag(size_t from, bool isDeclaration, size_t& end);
+
+    void HandleStartTag(size_t end, bool isEmpty);
+    void HandleEndTag(size_t end);
+    bool IsStartTag(const char* name) const;
+    XMLNode* ParseStartTag(XMLDocument& tagDocument, size_t end, bool isEmpty);
+    void CheckDepth(size_t depth) const;
+    void Compact();
+
+    std::unique_ptr<SVGDocumentImpl> mDocument;
+    // ParseLimits::maxDepth. Buffered fragments get parsed recursively by RapidXML.
+    size_t mMaxDepth{};
+
+    std::string mBuffer;
+    // Start of the next token in mBuffer.
+    size_t mPos{};
+    // Scan state of an incomplete token.
+    size_t mResume{};
+    char mQuote{};
+    int mBracketDepth{};
+
+    bool mHasRoot{};
+    bool mIsSVG{};
+    bool mIsDone{};
+    bool mHasError{};
+    ParseResult mResult{ParseResult::kInvalidDocument};
+    // Open elements handled on their start tags.
+    std::vector<ElementType> mOpenElements;
+    // Element currently being buffered.
+    size_t mFragmentStart{std::string::npos};
+    size_t mFragmentDepth{};
+};
+
+bool SVGStreamingParserImpl::Feed(const char* data, size_t length)
+{
+    if (mHasError || (!data && length))
+        return false;
+    // Content after the end of the root element is ignored.
+    if (mIsDone)
+        return true;
+
+    mBuffer.append(data, length);
+
+    try
+    {
+        mDocument->StartPass();
+        for (;;)
+        {
+            size_t end{};
+            auto type = NextToken(end);
+            if (type == TokenType::kIncomplete)
+                break;
+
+            if (type == TokenType::kStartTag || type == TokenType::kEmptyTag)
+                HandleStartTag(end, type == TokenType::kEmptyTag);
+            else if (type == TokenType::kEndTag)
+                HandleEndTag(end);
+
+            mPos = end;
+            if (mIsDone)
+            {
+                std::string().swap(mBuffer);
+                mPos = 0;
+                return true;
+            }
+        }
+    }
+    catch (const ParseLimitError& error)
+    {
+        mResult = error.Result();
+        mHasError = true;
+        return false;
+    }
+    catch (...)
+    {
+        mHasError = true;
+        return false;
+    }
+
+    Compact();
+    return true;
+}
+
+std::unique_ptr<SVGDocumentImpl> SVGStreamingParserImpl::Finish(ParseResult& result)
+{
+    result = mResult;
+    if (mHasError || !mIsDone)
+        return nullptr;
+
+    mDocument->FinishParsing();
+    result = ParseResult::kSuccess;
+    return std::move(mDocument);
+}
+
+SVGStreamingParserImpl::TokenType SVGStreamingParserImpl::NextToken(size_t& end)
+{
+    auto size = mBuffer.size();
+    if (mPos >= size)
+        return TokenType::kIncomplete;
+
+    if (mBuffer[mPos] != '<')
+    {
+        end = std::min(mBuffer.find('<', mPos), size);
+        return TokenType::kText;
+    }
+
+    if (mPos + 1 >= size)
+        return TokenType::kIncomplete;
+
+    switch (mBuffer[mPos + 1])
+    {
+    case '?':
+        return ScanUntil("?>", mPos + 2, end) ? TokenType::kMarkup : TokenType::kIncomplete;
+    case '/':
+        return ScanTag(mPos + 2, false, end) ? TokenType::kEndTag : TokenType::kIncomplete;
+    case '!':
+        if (mPos + 4 > size)
+            return TokenType::kIncomplete;
+        if (mBuffer.compare(mPos, 4, "<!--") == 0)
+            return ScanUntil("-->", mPos + 4, end) ? TokenType::kMarkup : TokenType::kIncomplete;
+        if (mBuffer[mPos + 2] == '[')
+        {
+            if (mPos + 9 > size)
+                return TokenType::kIncomplete;
+            if (mBuffer.compare(mPos, 9, "<![CDATA[") == 0)
+                return ScanUntil("]]>", mPos + 9, end) ? TokenType::kMarkup : TokenType::kIncomplete;
+        }
+        return ScanTag(mPos + 2, true, end) ? TokenType::kMarkup : TokenType::kIncomplete;
+    default:
+        if (!ScanTag(mPos + 1, false, end))
+            return TokenType::kIncomplete;
+        return mBuffer[end - 2] == '/' ? TokenType::kEmptyTag : TokenType::kStartTag;
+    }
+}
+
+bool SVGStreamingParserImpl::ScanUntil(const char* terminator, size_t from, size_t& end)
+{
+    auto terminatorLength = strlen(terminator);
+    auto found = mBuffer.find(terminator, std::max(from, mResume));
+    if (found == std::string::npos)
+    {
+        // The terminator may be split between chunks.
+        auto size = mBuffer.size();
+        mResume = size >= terminatorLength ? std::max(from, size - terminatorLength + 1) : from;
+        return false;
+    }
+    end = found + terminatorLength;
+    mResume = 0;
+    return true;
+}
+
+bool SVGStreamingParserImpl::ScanTag(size_t from, bool isDeclaration, size_t& end)
+{
+    auto size = mBuffer.size();
+    auto i = std::max(from, mResume);
+    for (; i < size; ++i)
+    {
+        char c = mBuffer[i];
+        if (mQuote)
+        {
+            if (c == mQuote)
+                mQuote = 0;
+        }
+        else if (c == '"' || c == '\'')
+            mQuote = c;
+        else if (isDeclaration && c == '[')
+            ++mBracketDepth;
+        else if (isDeclaration && c == ']')
+            --mBracketDepth;
+        else if (c == '>' && mBracketDepth <= 0)
+        {
+            end = i + 1;
+            mResume = 0;
+            mBracketDepth = 0;
+            return true;
+        }
+    }
+    mResume = i;
+    return false;
+}
+
+void SVGStreamingParserImpl::HandleStartTag(size_t end, bool isEmpty)
+{
+    if (mFragmentStart != std::string::npos)
+    {
+        CheckDepth(mOpenElements.size() + mFragmentDepth + 1);
+        if (!isEmpty)
+            ++mFragmentDepth;
+        return;
+    }
+
+    CheckDepth(mOpenElements.size() + 1);
+
+    if (!mHasRoot)
+    {
+        mHasRoot = true;
+        XMLDocument tagDocument;
+        mIsSVG = mDocument->ParseRoot(ParseStartTag(tagDocument, end, isEmpty));
+        if (isEmpty)
+            mIsDone = true;
+        else
+            mOpenElements.push_back(ElementType::kRoot);
+        return;
+    }
+
+    // Nothing gets rendered if the root element is not <svg>.
+    if (!mIsSVG)
+    {
+        if (!isEmpty)
+            mOpenElements.push_back(ElementType::kIgnored);
+        return;
+    }
+
+    bool isInDefs = mOpenElements.back() == ElementType::kDefs;
+    if (isEmpty)
+        mDocument->ParseFragment(mBuffer.data() + mPos, end - mPos, isInDefs);
+    else if (!isInDefs && IsStartTag("g"))
+    {
+        XMLDocument tagDocument;
+        mDocument->ParseGroupStart(ParseStartTag(tagDocument, end, false));
+        mOpenElements.push_back(ElementType::kGroup);
+    }
+    else if (!isInDefs && IsStartTag("defs"))
+    {
+        XMLDocument tagDocument;
+        mDocument->ParseDefsStart(ParseStartTag(tagDocument, end, false));
+        mOpenElements.push_back(ElementType::kDefs);
+    }
+    else if (!isInDefs && IsStartTag("symbol"))
+    {
+        XMLDocument tagDocument;
+        mDocument->ParseSymbolStart(ParseStartTag(tagDocument, end, false));
+        mOpenElements.push_back(ElementType::kSymbol);
+    }
+    else
+    {
+        mFragmentStart = mPos;
+        mFragmentDepth = 1;
+    }
+}
+
+void SVGStreamingParserImpl::HandleEndTag(size_t end)
+{
+    if (mFragmentStart != std::string::npos)
+    {
+        if (--mFragmentDepth == 0)
+        {
+            bool isInDefs = mOpenElements.back() == ElementType::kDefs;
+            mDocument->ParseFragment(mBuffer.data() + mFragmentStart, end - mFragmentStart, isInDefs);
+            mFragmentStart = std::string::npos;
+        }
+        return;
+    }
+
+    if (mOpenElements.empty())
+        throw std::runtime_error("Unexpected end tag");
+
+    auto type = mOpenElements.back();
+    mOpenElements.pop_back();
+    switch (type)
+    {
+    case ElementType::kRoot:
+        mIsDone = true;
+        break;
+    case ElementType::kGroup:
+        mDocument->ParseGroupEnd();
+        break;
+    case ElementType::kDefs:
+        mDocument->ParseDefsEnd();
+        break;
+    case ElementType::kSymbol:
+        mDocument->ParseSymbolEnd();
+        break;
+    case ElementType::kIgnored:
+        break;
+    }
+}
+
+bool SVGStreamingParserImpl::IsStartTag(const char* name) const
+{
+    auto length = strlen(name);
+    if (mBuffer.compare(mPos + 1, length, name) != 0)
+        return false;
+    char c = mBuffer[mPos + 1 + length];
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '/' || c == '>';
+}
+
+XMLNode* SVGStreamingParserImpl::ParseStartTag(XMLDocument& tagDocument, size_t end, bool isEmpty)
+{
+    // Turn the start tag into an empty element so that it can be parsed on its own.
+    auto length = end - mPos - 1;
+    auto buffer = tagDocument.allocate_string(nullptr, length + 3);
+    memcpy(buffer, mBuffer.data() + mPos, length);
+    if (!isEmpty)
+        buffer[length++] = '/';
+    buffer[length++] = '>';
+    buffer[length] = '\0';
+    tagDocument.parse<0>(buffer); // 0 means default parse flags
+
+    auto node = tagDocument.first_node();
+    if (!node)
+        throw std::runtime_error("Invalid start tag");
+    return node;
+}
+
+void SVGStreamingParserImpl::CheckDepth(size_t depth) const
+{
+    if (mMaxDepth && depth > mMaxDepth)
+        throw ParseLimitError(ParseResult::kDepthLimit);
+}
+
+void SVGStreamingParserImpl::Compact()
+{
+    // Drop everything that got consumed already. Keep the element that is
+    // currently being buffered.
+    auto keep = std::min(mPos, mFragmentStart);
+    if (keep == 0)
+        return;
+
+    mBuffer.erase(0, keep);
+    mPos -= keep;
+    if (mResume)
+        mResume -= keep;
+    if (mFragmentStart != std::string::npos)
+        mFragmentStart -= keep;
+}
+
+SVGStreamingParser::SVGStreamingParser(std::shared_ptr<SVGRenderer> renderer, const ParseOptions& options)
+    : mParser{new SVGStreamingParserImpl(renderer, options)}
+{
+}
+
+SVGStreamingParser::~SVGStreamingParser() {}
+
+bool SVGStreamingParser::Feed(const char* data, size_t length)
+{
+    if (!mParser)
+        return false;
+
+    return mParser->Feed(data, length);
+}
+
+std::unique_ptr<SVGDocument> SVGStreamingParser::Finish(ParseResult* result)
+{
+    auto failure = ParseResult::kInvalidDocument;
+    auto& parseResult = result ? *result : failure;
+    if (!mParser)
+    {
+        parseResult = ParseResult::kInvalidDocument;
+        return nullptr;
+    }
+
+    auto realSVGDoc = mParser->Finish(parseResult);
+    mParser.reset();
+    if (!realSVGDoc)
+        return nullptr;
+
+    auto retval = new SVGDocument();
+    retval->mDocument = std::move(realSVGDoc);
+
+    return std::unique_ptr<SVGDocument>(retval);
+}
+
+} // namespace SVGNative
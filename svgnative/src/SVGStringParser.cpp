@@ -15,6 +15,10 @@ governing permissions and limitations under the License.
 #include "SVGDocument.h"
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include <vector>
 #define _USE_MATH_DEFINES
 #include <cmath>
@@ -26,10 +30,11 @@ namespace SVGNative
 {
 void ArcToCurve(Path& path, float startX, float startY, float radiusX, float radiusY, float angle, bool large, bool sweep, float endX,
     float endY, float& endControlX, float& endControlY);
+bool DecimalToFloat(std::uint64_t mantissa, std::int64_t exponent, bool isTruncated, float& number);
 
 namespace SVGStringParser
 {
-using CharIt = std::string::const_iterator;
+using CharIt = const char*;
 
 inline bool isDigit(char c)
 {
@@ -44,14 +49,38 @@ inline bool isHex(char c)
 
 inline bool isWsp(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
 
+inline char toLower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+// Compares the characters at pos with the NUL-terminated string str.
+inline bool StartsWith(CharIt pos, const CharIt& end, const char* str)
+{
+    for (; *str; ++str, ++pos)
+    {
+        if (pos == end || *pos != *str)
+            return false;
+    }
+    return true;
+}
+
+// Same as StartsWith but ignores ASCII case. str must be lower case.
+inline bool StartsWithIgnoreCase(CharIt pos, const CharIt& end, const char* str)
+{
+    for (; *str; ++str, ++pos)
+    {
+        if (pos == end || toLower(*pos) != *str)
+            return false;
+    }
+    return true;
+}
+
 inline bool SkipOptWspOrDelimiter(CharIt& pos, const CharIt& end, bool isAllOptional = true, char delimiter = ',')
 {
-    if (!isAllOptional && !isWsp(*pos) && *pos != delimiter)
+    if (!isAllOptional && (pos == end || (!isWsp(*pos) && *pos != delimiter)))
         return false;
 
     while (pos < end && isWsp(*pos))
         pos++;
-    if (*pos == delimiter)
+    if (pos < end && *pos == delimiter)
         pos++;
     while (pos < end && isWsp(*pos))
         pos++;
@@ -63,7 +92,7 @@ inline bool SkipOptWspDelimiterOptWsp(CharIt& pos, const CharIt& end, char delim
     bool hasDelimiter{};
     while (pos < end && isWsp(*pos))
         pos++;
-    if (*pos == delimiter)
+    if (pos < end && *pos == delimiter)
     {
         hasDelimiter = true;
         pos++;
@@ -92,6 +121,62 @@ inline bool ParseDigit(CharIt& pos, const CharIt& end, std::int32_t& digit)
     return true;
 }
 
+// Reads 8 bytes in little endian order.
+inline std::uint64_t ReadEightBytes(CharIt pos)
+{
+    std::uint64_t value;
+    memcpy(&value, pos, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+// SWAR check whether all 8 bytes are ASCII digits.
+inline bool IsMadeOfEightDigits(std::uint64_t value)
+{
+    return !(((value + 0x4646464646464646) | (value - 0x3030303030303030)) & 0x8080808080808080);
+}
+
+// SWAR conversion of 8 ASCII digits to their integer value.
+inline std::uint32_t ParseEightDigits(std::uint64_t value)
+{
+    const std::uint64_t mask = 0x000000FF000000FF;
+    const std::uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+    const std::uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+    value -= 0x3030303030303030;
+    value = (value * 10) + (value >> 8);
+    value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+    return static_cast<std::uint32_t>(value);
+}
+
+inline void ParseDigits(CharIt& pos, const CharIt& end, std::uint64_t& mantissa)
+{
+    while (end - pos >= 8)
+    {
+        auto value = ReadEightBytes(pos);
+        if (!IsMadeOfEightDigits(value))
+            break;
+        mantissa = mantissa * 100000000 + ParseEightDigits(value);
+        pos += 8;
+    }
+    while (pos < end && isDigit(*pos))
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*pos++ - '0');
+}
+
+// Slow path for numbers with more than 19 significant digits where the truncated
+// mantissa does not determine the result. strtof is locale dependent, so only
+// pass digits and an exponent.
+static float SlowDecimalToFloat(CharIt integerStart, CharIt integerEnd, CharIt fractionStart, CharIt fractionEnd, std::int64_t exponent)
+{
+    std::string digits(integerStart, integerEnd);
+    digits.append(fractionStart, fractionEnd);
+    exponent -= std::distance(fractionStart, fractionEnd);
+    digits.push_back('e');
+    digits.append(std::to_string(exponent));
+    return strtof(digits.c_str(), nullptr);
+}
+
 static bool ParseScientificNumber(CharIt& pos, const CharIt& end, float& number)
 {
     if (pos == end)
@@ -99,80 +184,104 @@ static bool ParseScientificNumber(CharIt& pos, const CharIt& end, float& number)
 
     number = 0;
 
-    float sign{1};
-    float exponent{0};
-    float exponentSign{1};
-
+    bool isNegative{};
     if (*pos == '-' || *pos == '+')
     {
-        if (*pos == '-')
-            sign = -1;
+        isNegative = *pos == '-';
         pos++;
         if (pos == end)
             return false;
     }
 
-    bool hasNumber{};
-    bool hasFraction{};
-    while (pos < end && isDigit(*pos))
-    {
-        hasNumber = true;
-        number *= 10;
-        number += static_cast<float>(*pos++ - '0');
-    }
-    if (pos == end)
-    {
-        number *= sign;
-        return std::isfinite(number);
-    }
+    // Accumulate all digits in a 64-bit mantissa. It may overflow if there are
+    // more than 19 digits. This is handled below.
+    std::uint64_t mantissa{};
+    auto integerStart = pos;
+    ParseDigits(pos, end, mantissa);
+    auto integerEnd = pos;
+    auto fractionStart = pos;
+    auto fractionEnd = pos;
 
-    if (*pos == '.')
+    if (pos < end && *pos == '.')
     {
         pos++;
         if (pos == end || !isDigit(*pos))
             return false;
 
-        float division = 10;
-        while (pos < end && isDigit(*pos))
-        {
-            hasFraction = true;
-            number += static_cast<float>(*pos++ - '0') / division;
-            division *= 10;
-        }
-    }
-    if (!hasFraction && !hasNumber)
-        return false;
-
-    if (pos == end || (*pos != 'e' && *pos != 'E'))
-    {
-        number *= sign;
-        return std::isfinite(number);
+        fractionStart = pos;
+        ParseDigits(pos, end, mantissa);
+        fractionEnd = pos;
     }
-
-    pos++;
-    if (pos == end)
+    if (integerStart == integerEnd && fractionStart == fractionEnd)
         return false;
 
-    if (*pos == '-' || *pos == '+')
+    std::int64_t exponent{};
+    if (pos < end && (*pos == 'e' || *pos == 'E'))
     {
-        if (*pos == '-')
-            exponentSign = -1;
         pos++;
         if (pos == end)
             return false;
+
+        bool isNegativeExponent{};
+        if (*pos == '-' || *pos == '+')
+        {
+            isNegativeExponent = *pos == '-';
+            pos++;
+            if (pos == end)
+                return false;
+        }
+        if (!isDigit(*pos))
+            return false;
+
+        while (pos < end && isDigit(*pos))
+        {
+            // Saturate. Anything this big is 0 or infinite anyway.
+            if (exponent < 0x10000000)
+                exponent = exponent * 10 + (*pos - '0');
+            pos++;
+        }
+        if (isNegativeExponent)
+            exponent = -exponent;
     }
-    if (!isDigit(*pos))
-        return false;
 
-    while (pos < end && isDigit(*pos))
+    auto explicitExponent = exponent;
+    auto digitCount = std::distance(integerStart, integerEnd) + std::distance(fractionStart, fractionEnd);
+    bool isTruncated{};
+    if (digitCount > 19)
     {
-        exponent *= 10.0f;
-        exponent += static_cast<float>(*pos++ - '0');
+        // Leading zeros are not significant.
+        for (auto it = integerStart; it != fractionEnd && (*it == '0' || *it == '.'); ++it)
+        {
+            if (*it == '0')
+                --digitCount;
+        }
+        if (digitCount > 19)
+        {
+            // Keep the first 19 significant digits.
+            isTruncated = true;
+            const std::uint64_t minNineteenDigitInteger{1000000000000000000};
+            mantissa = 0;
+            auto it = integerStart;
+            while (mantissa < minNineteenDigitInteger && it != integerEnd)
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(*it++ - '0');
+            if (mantissa >= minNineteenDigitInteger)
+                exponent += std::distance(it, integerEnd);
+            else
+            {
+                it = fractionStart;
+                while (mantissa < minNineteenDigitInteger && it != fractionEnd)
+                    mantissa = mantissa * 10 + static_cast<std::uint64_t>(*it++ - '0');
+                exponent -= std::distance(fractionStart, it);
+            }
+        }
     }
-    if (exponent)
-        number *= pow(10.0f, exponentSign * exponent);
+    if (!isTruncated)
+        exponent -= std::distance(fractionStart, fractionEnd);
 
-    number *= sign;
+    if (!DecimalToFloat(mantissa, exponent, isTruncated, number))
+        number = SlowDecimalToFloat(integerStart, integerEnd, fractionStart, fractionEnd, explicitExponent);
+    if (isNegative)
+        number = -number;
     return std::isfinite(number);
 }
 
@@ -248,19 +357,17 @@ static bool ParseLengthOrPercentage(
         return false;
 
     // https://www.w3.org/TR/css-values-3/#absolute-lengths
-    auto unit = std::string(start, start + 2);
-    std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
-    if (unit.compare("cm") == 0)
+    if (StartsWithIgnoreCase(start, end, "cm"))
         absLengthInUnits *= (96.0f / 2.54f);
-    else if (unit.compare("mm") == 0)
+    else if (StartsWithIgnoreCase(start, end, "mm"))
         absLengthInUnits *= (9.6f / 2.54f);
-    else if (unit.compare("in") == 0)
+    else if (StartsWithIgnoreCase(start, end, "in"))
         absLengthInUnits *= 96.0f;
-    else if (unit.compare("pc") == 0)
+    else if (StartsWithIgnoreCase(start, end, "pc"))
         absLengthInUnits *= (96.0f / 6.0f);
-    else if (unit.compare("pt") == 0)
+    else if (StartsWithIgnoreCase(start, end, "pt"))
         absLengthInUnits *= (96.0f / 72.0f);
-    else if (unit.compare("px") == 0)
+    else if (StartsWithIgnoreCase(start, end, "px"))
         absLengthInUnits *= 1.0f;
     else
         return false;
@@ -295,10 +402,10 @@ static void ParseListOfNumbers(CharIt& pos, const CharIt& end, std::vector<float
     }
 }
 
-bool ParseLengthOrPercentage(const std::string& lengthString, float relDimensionLength, float& absLengthInUnits, bool useQuirks /*= false*/)
+bool ParseLengthOrPercentage(const char* lengthString, size_t length, float relDimensionLength, float& absLengthInUnits, bool useQuirks /*= false*/)
 {
-    auto pos = lengthString.begin();
-    auto end = lengthString.end();
+    CharIt pos = lengthString;
+    CharIt end = lengthString + length;
     SkipOptWsp(pos, end);
     if (!ParseLengthOrPercentage(pos, end, relDimensionLength, absLengthInUnits, useQuirks))
         return false;
@@ -306,10 +413,10 @@ bool ParseLengthOrPercentage(const std::string& lengthString, float relDimension
     return !SkipOptWsp(pos, end);
 }
 
-bool ParseNumber(const std::string& numberString, float& number)
+bool ParseNumber(const char* numberString, size_t length, float& number)
 {
-    auto pos = numberString.begin();
-    auto end = numberString.end();
+    CharIt pos = numberString;
+    CharIt end = numberString + length;
 
     if (!SkipOptWsp(pos, end))
         return false;
@@ -318,10 +425,10 @@ bool ParseNumber(const std::string& numberString, float& number)
     return !SkipOptWsp(pos, end);
 }
 
-bool ParseListOfNumbers(const std::string& numberListString, std::vector<float>& numberList, bool isAllOptional /*= true*/)
+bool ParseListOfNumbers(const char* numberListString, size_t length, std::vector<float>& numberList, bool isAllOptional /*= true*/)
 {
-    auto pos = numberListString.begin();
-    auto end = numberListString.end();
+    CharIt pos = numberListString;
+    CharIt end = numberListString + length;
 
     if (!SkipOptWsp(pos, end))
         return true;
@@ -331,11 +438,11 @@ bool ParseListOfNumbers(const std::string& numberListString, std::vector<float>&
     return !SkipOptWsp(pos, end);
 }
 
-bool ParseListOfLengthOrPercentage(const std::string& lengthOrPercentageListString, float relDimensionLength,
+bool ParseListOfLengthOrPercentage(const char* lengthOrPercentageListString, size_t length, float relDimensionLength,
     std::vector<float>& numberList, bool isAllOptional /*= true*/)
 {
-    auto pos = lengthOrPercentageListString.begin();
-    auto end = lengthOrPercentageListString.end();
+    CharIt pos = lengthOrPercentageListString;
+    CharIt end = lengthOrPercentageListString + length;
 
     numberList.clear();
 
@@ -362,10 +469,10 @@ bool ParseListOfLengthOrPercentage(const std::string& lengthOrPercentageListStri
     return !SkipOptWsp(pos, end);
 }
 
-bool ParseListOfStrings(const std::string& stringListString, std::vector<std::string>& stringList)
+bool ParseListOfStrings(const char* stringListString, size_t length, std::vector<std::string>& stringList)
 {
-    auto pos = stringListString.begin();
-    auto end = stringListString.end();
+    CharIt pos = stringListString;
+    CharIt end = stringListString + length;
 
     if (!SkipOptWsp(pos, end))
         return false;
@@ -380,10 +487,39 @@ bool ParseListOfStrings(const std::string& stringListString, std::vector<std::st
     return true;
 }
 
-void ParsePathString(const std::string& pathString, Path& p)
+void ParsePoints(const char* pointsString, size_t length, bool isClosed, Path& p)
 {
-    auto pos = pathString.begin();
-    auto end = pathString.end();
+    CharIt pos = pointsString;
+    CharIt end = pointsString + length;
+    if (!SkipOptWsp(pos, end))
+        return;
+
+    // Same grammar as ParseListOfNumbers() but every coordinate pair goes to p as soon
+    // as it is complete. An odd coordinate at the end is ignored.
+    size_t count{};
+    float x{};
+    float number{};
+    for (auto temp = pos; ParseScientificNumber(temp, end, number);)
+    {
+        if (count++ % 2 == 0)
+            x = number;
+        else if (count == 2)
+            p.MoveTo(x, number);
+        else
+            p.LineTo(x, number);
+
+        pos = temp;
+        if (pos >= end || !SkipOptWspOrDelimiter(temp, end))
+            break;
+    }
+    if (isClosed && count > 1)
+        p.ClosePath();
+}
+
+void ParsePathString(const char* pathString, size_t length, Path& p)
+{
+    CharIt pos = pathString;
+    CharIt end = pathString + length;
     if (!SkipOptWsp(pos, end))
         return;
 
@@ -726,145 +862,144 @@ void ParsePathString(const std::string& pathString, Path& p)
     }
 }
 
-std::unique_ptr<Transform> ParseTransform(const std::string& transformString, std::function<std::unique_ptr<Transform>()> createTransform)
+// Multiplies matrix with the matrix {a, b, c, d, tx, ty} from the right. Points get
+// transformed by the new matrix first.
+static void ConcatMatrix(TransformMatrix& matrix, float a, float b, float c, float d, float tx, float ty)
+{
+    TransformMatrix result{{
+        a * matrix[0] + b * matrix[2],
+        a * matrix[1] + b * matrix[3],
+        c * matrix[0] + d * matrix[2],
+        c * matrix[1] + d * matrix[3],
+        tx * matrix[0] + ty * matrix[2] + matrix[4],
+        tx * matrix[1] + ty * matrix[3] + matrix[5]
+    }};
+    matrix = result;
+}
+
+static void RotateMatrix(TransformMatrix& matrix, float angle)
+{
+    angle = static_cast<float>(M_PI / 180.0 * angle);
+    float cosAngle = cos(angle);
+    float sinAngle = sin(angle);
+    ConcatMatrix(matrix, cosAngle, sinAngle, -sinAngle, cosAngle, 0.0f, 0.0f);
+}
+
+// Parses the parenthesized argument list of a transform function into arguments.
+// Returns the number of arguments or 0 on a syntax error. More than 6 arguments
+// are never valid. The 7th stops the parsing.
+static size_t ParseTransformArguments(CharIt& pos, const CharIt& end, float (&arguments)[7])
+{
+    if (!SkipOptWsp(pos, end))
+        return 0;
+    if (*pos++ != '(')
+        return 0;
+    if (!SkipOptWsp(pos, end))
+        return 0;
+
+    size_t count{};
+    auto temp = pos;
+    if (!ParseScientificNumber(temp, end, arguments[count]))
+        return 0;
+    pos = temp;
+    ++count;
+    while (pos < end && count < 7)
+    {
+        temp = pos;
+        if (!SkipOptWspOrDelimiter(temp, end, true))
+            break;
+        if (!ParseScientificNumber(temp, end, arguments[count]))
+            break;
+        ++count;
+        pos = temp;
+    }
+
+    if (!SkipOptWsp(pos, end))
+        return 0;
+    if (*pos++ != ')')
+        return 0;
+    return count;
+}
+
+bool ParseTransform(const char* transformString, size_t length, TransformMatrix& matrix)
 {
     // https://www.w3.org/TR/css-transforms-1/#svg-syntax
-    auto pos = transformString.begin();
-    auto end = transformString.end();
+    CharIt pos = transformString;
+    CharIt end = transformString + length;
     if (!SkipOptWsp(pos, end))
-        return nullptr;
+        return false;
 
-    auto matrix = createTransform();
+    matrix = {{1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f}};
+    float arguments[7];
     bool isFirstTransform{true};
     while (pos < end)
     {
         if (!SkipOptWsp(pos, end))
-            return matrix;
+            return true;
         if (!isFirstTransform && *pos == ',')
         {
             if (!SkipOptWspOrDelimiter(pos, end, false))
-                return nullptr;
+                return false;
         }
-        auto length = std::distance(pos, end);
-        if (length >= 6 && std::string(pos, pos + 6).compare("matrix") == 0)
+        if (StartsWith(pos, end, "matrix"))
         {
             pos += 6;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != '(')
-                return nullptr;
-            std::vector<float> numberList;
-            ParseListOfNumbers(pos, end, numberList);
-            if (numberList.size() != 6 || !SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != ')')
-                return nullptr;
-            auto newMatrix = createTransform();
-            newMatrix->Set(numberList[0], numberList[1], numberList[2], numberList[3], numberList[4], numberList[5]);
-            matrix->Concat(*newMatrix);
+            if (ParseTransformArguments(pos, end, arguments) != 6)
+                return false;
+            ConcatMatrix(matrix, arguments[0], arguments[1], arguments[2], arguments[3], arguments[4], arguments[5]);
         }
-        else if (length >= 9 && std::string(pos, pos + 9).compare("translate") == 0)
+        else if (StartsWith(pos, end, "translate"))
         {
             pos += 9;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != '(')
-                return nullptr;
-            std::vector<float> numberList;
-            ParseListOfNumbers(pos, end, numberList);
-            auto size = numberList.size();
-            if ((size != 1 && size != 2) || !SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != ')')
-                return nullptr;
-            matrix->Translate(numberList[0], (size == 1 ? 0 : numberList[1]));
+            auto count = ParseTransformArguments(pos, end, arguments);
+            if (count != 1 && count != 2)
+                return false;
+            ConcatMatrix(matrix, 1.0f, 0.0f, 0.0f, 1.0f, arguments[0], (count == 1 ? 0 : arguments[1]));
         }
-        else if (length >= 5 && std::string(pos, pos + 5).compare("scale") == 0)
+        else if (StartsWith(pos, end, "scale"))
         {
             pos += 5;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != '(')
-                return nullptr;
-            std::vector<float> numberList;
-            ParseListOfNumbers(pos, end, numberList);
-            auto size = numberList.size();
-            if ((size != 1 && size != 2) || !SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != ')')
-                return nullptr;
-            matrix->Scale(numberList[0], (size == 1 ? numberList[0] : numberList[1]));
+            auto count = ParseTransformArguments(pos, end, arguments);
+            if (count != 1 && count != 2)
+                return false;
+            ConcatMatrix(matrix, arguments[0], 0.0f, 0.0f, (count == 1 ? arguments[0] : arguments[1]), 0.0f, 0.0f);
         }
-        else if (length >= 6 && std::string(pos, pos + 6).compare("rotate") == 0)
+        else if (StartsWith(pos, end, "rotate"))
         {
             pos += 6;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != '(')
-                return nullptr;
-            std::vector<float> numberList;
-            ParseListOfNumbers(pos, end, numberList);
-            auto size = numberList.size();
-            if ((size != 1 && size != 3) || !SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != ')')
-                return nullptr;
-            if (size == 3)
+            auto count = ParseTransformArguments(pos, end, arguments);
+            if (count != 1 && count != 3)
+                return false;
+            if (count == 3)
             {
-                matrix->Translate(numberList[1], numberList[2]);
-                matrix->Rotate(numberList[0]);
-                matrix->Translate(-numberList[1], -numberList[2]);
+                ConcatMatrix(matrix, 1.0f, 0.0f, 0.0f, 1.0f, arguments[1], arguments[2]);
+                RotateMatrix(matrix, arguments[0]);
+                ConcatMatrix(matrix, 1.0f, 0.0f, 0.0f, 1.0f, -arguments[1], -arguments[2]);
             }
             else
-                matrix->Rotate(numberList[0]);
+                RotateMatrix(matrix, arguments[0]);
         }
-        else if (length >= 5 && std::string(pos, pos + 5).compare("skewX") == 0)
+        else if (StartsWith(pos, end, "skewX"))
         {
             pos += 5;
-            float number{};
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != '(')
-                return nullptr;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (!ParseScientificNumber(pos, end, number))
-                return nullptr;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != ')')
-                return nullptr;
-            auto newMatrix = createTransform();
-            number *= M_PI / 180.0f;
-            newMatrix->Set(1.0f, 0.0f, tan(number), 1.0f, 0.0f, 0.0f);
-            matrix->Concat(*newMatrix);
+            if (ParseTransformArguments(pos, end, arguments) != 1)
+                return false;
+            float number = arguments[0] * static_cast<float>(M_PI / 180.0f);
+            ConcatMatrix(matrix, 1.0f, 0.0f, tan(number), 1.0f, 0.0f, 0.0f);
         }
-        else if (length >= 5 && std::string(pos, pos + 5).compare("skewY") == 0)
+        else if (StartsWith(pos, end, "skewY"))
         {
             pos += 5;
-            float number{};
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != '(')
-                return nullptr;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (!ParseScientificNumber(pos, end, number))
-                return nullptr;
-            if (!SkipOptWsp(pos, end))
-                return nullptr;
-            if (*pos++ != ')')
-                return nullptr;
-            auto newMatrix = createTransform();
-            number *= M_PI / 180.0f;
-            newMatrix->Set(1.0f, tan(number), 0.0f, 1.0f, 0.0f, 0.0f);
-            matrix->Concat(*newMatrix);
+            if (ParseTransformArguments(pos, end, arguments) != 1)
+                return false;
+            float number = arguments[0] * static_cast<float>(M_PI / 180.0f);
+            ConcatMatrix(matrix, 1.0f, tan(number), 0.0f, 1.0f, 0.0f, 0.0f);
         }
         else
-            return nullptr;
+            return false;
         isFirstTransform = false;
     }
-    return matrix;
+    return true;
 }
 
 static bool ParseCustomPropertyName(CharIt& pos, const CharIt& end, std::string& customPropertyName)
@@ -882,8 +1017,10 @@ static bool ParseCustomPropertyName(CharIt& pos, const CharIt& end, std::string&
         if (++pos == end)
             return false;
     }
-    customPropertyName = std::string(startPos, pos);
-    return !customPropertyName.empty();
+    if (pos == startPos)
+        return false;
+    customPropertyName.assign(startPos, pos);
+    return true;
 }
 
 static bool ParseColor(CharIt& pos, const CharIt& end, ColorImpl& paint, bool supportsCurrentColor, SVGDocumentImpl::Result& result)
@@ -895,18 +1032,21 @@ static bool ParseColor(CharIt& pos, const CharIt& end, ColorImpl& paint, bool su
     if (*pos == '#')
     {
         auto start = ++pos;
+        std::uint32_t num{};
         while (pos < end && isHex(*pos))
-            pos++;
-        std::string hexString(start, pos);
-        auto num = stoi(hexString, nullptr, 16);
-        if (hexString.size() == 3)
+        {
+            char c = toLower(*pos++);
+            num = (num << 4) | static_cast<std::uint32_t>(isDigit(c) ? c - '0' : c - 'a' + 10);
+        }
+        auto hexLength = std::distance(start, pos);
+        if (hexLength == 3)
         {
             // Hex color with 3 characters: #FF0 -> #FFFF00
             color[0] = (num / 0x100) / 15.0f;
             color[1] = ((num / 0x10) % 0x10) / 15.0f;
             color[2] = (num % 0x10) / 15.0f;
         }
-        else if (hexString.size() == 6)
+        else if (hexLength == 6)
         {
             // Hex color with 6 characters: #FFFF00
             color[0] = (num / 0x10000) / 255.0f;
@@ -923,191 +1063,149 @@ static bool ParseColor(CharIt& pos, const CharIt& end, ColorImpl& paint, bool su
         return true;
     }
 
-    auto length = std::distance(pos, end);
-    if (length >= 4)
+    if (StartsWithIgnoreCase(pos, end, "rgb("))
     {
-        std::string char4string(pos, pos + 4);
-        std::transform(char4string.begin(), char4string.end(), char4string.begin(), ::tolower);
-        if (char4string.compare("rgb(") == 0)
+        result = SVGDocumentImpl::Result::kInvalid;
+        pos += 4;
+        std::int32_t r{};
+        std::int32_t g{};
+        std::int32_t b{};
+        if (!SkipOptWsp(pos, end))
+            return false;
+        if (!ParseDigit(pos, end, r))
+            return false;
+        if (!SkipOptWspDelimiterOptWsp(pos, end))
+            return false;
+        if (!ParseDigit(pos, end, g))
+            return false;
+        if (!SkipOptWspDelimiterOptWsp(pos, end))
+            return false;
+        if (!ParseDigit(pos, end, b))
+            return false;
+        if (!SkipOptWsp(pos, end))
+            return false;
+        if (*pos++ != ')')
+            return false;
+        color[0] = std::min(255, r) / 255.0f;
+        color[1] = std::min(255, g) / 255.0f;
+        color[2] = std::min(255, b) / 255.0f;
+        paint = color;
+        result = SVGDocumentImpl::Result::kSuccess;
+        return true;
+    }
+    if (StartsWithIgnoreCase(pos, end, "var("))
+    {
+        result = SVGDocumentImpl::Result::kInvalid;
+        pos += 4;
+        if (!SkipOptWsp(pos, end))
+            return false;
+        std::string customPropertyName;
+        if (!ParseCustomPropertyName(pos, end, customPropertyName))
+            return false;
+        ColorImpl fallbackPaint = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
+        if (!SkipOptWsp(pos, end))
+            return false;
+        if (*pos != ')')
         {
-            result = SVGDocumentImpl::Result::kInvalid;
-            pos += 4;
-            std::int32_t r{};
-            std::int32_t g{};
-            std::int32_t b{};
-            if (!SkipOptWsp(pos, end))
-                return false;
-            if (!ParseDigit(pos, end, r))
-                return false;
-            if (!SkipOptWspDelimiterOptWsp(pos, end))
-                return false;
-            if (!ParseDigit(pos, end, g))
-                return false;
             if (!SkipOptWspDelimiterOptWsp(pos, end))
                 return false;
-            if (!ParseDigit(pos, end, b))
+            if (!ParseColor(pos, end, fallbackPaint, true, result) || result != SVGDocumentImpl::Result::kSuccess)
                 return false;
             if (!SkipOptWsp(pos, end))
                 return false;
-            if (*pos++ != ')')
+            if (*pos != ')')
                 return false;
-            color[0] = std::min(255, r) / 255.0f;
-            color[1] = std::min(255, g) / 255.0f;
-            color[2] = std::min(255, b) / 255.0f;
-            paint = color;
-            result = SVGDocumentImpl::Result::kSuccess;
-            return true;
         }
-        if (char4string.compare("var(") == 0)
+        pos++;
+        if (fallbackPaint.type() != typeid(Color))
         {
-            result = SVGDocumentImpl::Result::kInvalid;
-            pos += 4;
-            if (!SkipOptWsp(pos, end))
-                return false;
-            std::string customPropertyName;
-            if (!ParseCustomPropertyName(pos, end, customPropertyName))
-                return false;
-            ColorImpl fallbackPaint = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
-            if (!SkipOptWsp(pos, end))
-                return false;
-            if (*pos != ')')
-            {
-                if (!SkipOptWspDelimiterOptWsp(pos, end))
-                    return false;
-                if (!ParseColor(pos, end, fallbackPaint, true, result) || result != SVGDocumentImpl::Result::kSuccess)
-                    return false;
-                if (!SkipOptWsp(pos, end))
-                    return false;
-                if (*pos != ')')
-                    return false;
-            }
-            pos++;
-            if (fallbackPaint.type() != typeid(Color))
-            {
-                // Fallback color was a variable. This is allowed according to
-                // CSS syntax but requires recursive C++ variables. Ignoring it
-                // and setting fallback color to black is a simpler approach for now.
-                fallbackPaint = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
-            }
-            paint = Variable{customPropertyName, boost::get<Color>(fallbackPaint)};
-            result = SVGDocumentImpl::Result::kSuccess;
-            return true;
+            // Fallback color was a variable. This is allowed according to
+            // CSS syntax but requires recursive C++ variables. Ignoring it
+            // and setting fallback color to black is a simpler approach for now.
+            fallbackPaint = Color{{0.0f, 0.0f, 0.0f, 1.0f}};
         }
+        paint = Variable{customPropertyName, boost::get<Color>(fallbackPaint)};
+        result = SVGDocumentImpl::Result::kSuccess;
+        return true;
     }
 
     // Parse CSS named Colors.
-    for (const auto& namedColor : gCSSNamedColors)
+    // Color keywords consist of ASCII letters only. The whole word must match.
+    auto wordEnd = pos;
+    while (wordEnd != end && ((*wordEnd >= 'a' && *wordEnd <= 'z') || (*wordEnd >= 'A' && *wordEnd <= 'Z')))
+        ++wordEnd;
+    if (auto namedColor = FindCSSNamedColor(pos, static_cast<size_t>(wordEnd - pos)))
     {
-        auto namedColorSize = std::get<1>(namedColor);
-        if (std::distance(pos, end) < static_cast<const long>(namedColorSize))
-            continue;
-        std::string nameString(pos, pos + namedColorSize);
-        std::transform(nameString.begin(), nameString.end(), nameString.begin(), ::tolower);
-        if (std::string(nameString).compare(std::get<0>(namedColor)) == 0)
-        {
-            color = std::get<2>(namedColor);
-            paint = color;
-            result = SVGDocumentImpl::Result::kSuccess;
-            pos += namedColorSize;
-            return true;
-        }
+        color = namedColor->color;
+        paint = color;
+        result = SVGDocumentImpl::Result::kSuccess;
+        pos = wordEnd;
+        return true;
     }
 
-    if (length >= 12 && supportsCurrentColor)
+    if (supportsCurrentColor && StartsWithIgnoreCase(pos, end, "currentcolor"))
     {
-        std::string currentColorString(pos, pos + 12);
-        std::transform(currentColorString.begin(), currentColorString.end(), currentColorString.begin(), ::tolower);
-        if (currentColorString.compare("currentcolor") == 0)
-        {
-            paint = ColorKeys::kCurrentColor;
-            result = SVGDocumentImpl::Result::kSuccess;
-            pos += 12;
-            return true;
-        }
+        paint = ColorKeys::kCurrentColor;
+        result = SVGDocumentImpl::Result::kSuccess;
+        pos += 12;
+        return true;
     }
 
     result = SVGDocumentImpl::Result::kInvalid;
     return false;
 }
 
-SVGDocumentImpl::Result ParseColor(const std::string& colorString, ColorImpl& paint, bool supportsCurrentColor /*= true*/)
+SVGDocumentImpl::Result ParseColor(const char* colorString, size_t length, ColorImpl& paint, bool supportsCurrentColor /*= true*/)
 {
-    auto pos = colorString.begin();
-    auto end = colorString.end();
+    CharIt pos = colorString;
+    CharIt end = colorString + length;
     SVGDocumentImpl::Result result{SVGDocumentImpl::Result::kInvalid};
     if (ParseColor(pos, end, paint, supportsCurrentColor, result))
         return result;
     return SVGDocumentImpl::Result::kInvalid;
 }
 
-SVGDocumentImpl::Result ParsePaint(const std::string& colorString, const std::map<std::string, GradientImpl>& gradientMap,
-    const std::array<float, 4>& viewBox, PaintImpl& paint)
+SVGDocumentImpl::Result ParsePaint(const char* colorString, size_t length,
+    const std::map<std::string, std::shared_ptr<const GradientImpl>>& gradientMap, PaintImpl& paint)
 {
     SVGDocumentImpl::Result result{SVGDocumentImpl::Result::kInvalid};
-    if (!colorString.size())
+    if (!length)
         return result;
 
-    auto pos = colorString.begin();
-    auto end = colorString.end();
+    CharIt pos = colorString;
+    CharIt end = colorString + length;
     if (!SkipOptWsp(pos, end))
         return result;
 
     SVGDocumentImpl::Result urlResult{SVGDocumentImpl::Result::kInvalid};
-    if (std::distance(pos, end) >= 5)
+    if (StartsWith(pos, end, "url(#"))
     {
-        std::string urlString(pos, pos + 5);
-        if (urlString.find("url(#") == 0)
+        // FIXME: Add proper parser for url()
+        auto closing = std::find(pos, end, ')');
+        if (closing == end)
+            return SVGDocumentImpl::Result::kInvalid;
+        auto it = gradientMap.find(std::string(pos + 5, closing));
+        if (it != gradientMap.end())
         {
-            // FIXME: Add proper parser for url()
-            auto position = colorString.find(')');
-            if (position == std::string::npos)
-                return SVGDocumentImpl::Result::kInvalid;
-            auto id = colorString.substr(5, position - 5);
-            auto it = gradientMap.find(id);
-            if (it != gradientMap.end())
-            {
-                // * No color stops means the same as if 'none' was specified.
-                // * 1 color stop means solid color fill.
-                // https://www.w3.org/TR/SVG11/pservers.html#GradientStops (see notes at the end)
-                // Can not be determined earlier.
-                auto gradient = it->second;
-                if (gradient.internalColorStops.empty())
-                    return SVGDocumentImpl::Result::kDisabled;
-                else if (gradient.internalColorStops.size() == 1)
-                    paint = std::get<1>(gradient.internalColorStops.front());
-                else
-                {
-                    // Percentage values that do neither correlate to horizontal nor vertical dimensions
-                    // need to be relative to the hypotenuse of both. Example: r="50%"
-                    float sqr = sqrtf(viewBox[2] * viewBox[2] + viewBox[3] * viewBox[3]);
-                    if (gradient.type == GradientType::kLinearGradient)
-                    {
-                        // https://www.w3.org/TR/SVG11/pservers.html#LinearGradients
-                        gradient.x1 = std::isfinite(gradient.x1) ? gradient.x1 : 0;
-                        gradient.y1 = std::isfinite(gradient.y1) ? gradient.y1 : 0;
-                        gradient.x2 = std::isfinite(gradient.x2) ? gradient.x2 : viewBox[2];
-                        gradient.y2 = std::isfinite(gradient.y2) ? gradient.y2 : 0;
-                    }
-                    else
-                    {
-                        // https://www.w3.org/TR/SVG11/pservers.html#RadialGradients
-                        gradient.cx = std::isfinite(gradient.cx) ? gradient.cx : 0.5f * viewBox[2];
-                        gradient.cy = std::isfinite(gradient.cy) ? gradient.cy : 0.5f * viewBox[3];
-                        gradient.fx = std::isfinite(gradient.fx) ? gradient.fx : gradient.cx;
-                        gradient.fy = std::isfinite(gradient.fy) ? gradient.fy : gradient.cy;
-                        gradient.r = std::isfinite(gradient.r) ? gradient.r : 0.5f * sqr;
-                    }
-                    paint = gradient;
-                }
-            }
-            pos += position + 1;
+            // * No color stops means the same as if 'none' was specified.
+            // * 1 color stop means solid color fill.
+            // https://www.w3.org/TR/SVG11/pservers.html#GradientStops (see notes at the end)
+            // Can not be determined earlier.
+            const auto& gradient = it->second;
+            if (gradient->internalColorStops.empty())
+                return SVGDocumentImpl::Result::kDisabled;
+            else if (gradient->internalColorStops.size() == 1)
+                paint = std::get<1>(gradient->internalColorStops.front());
+            else
+                paint = gradient;
         }
+        pos = closing + 1;
     }
     if (!SkipOptWsp(pos, end))
         return result;
 
     ColorImpl altPaint;
-    if (std::distance(pos, end) >= 4 && std::string(pos, pos + 4).compare("none") == 0)
+    if (StartsWith(pos, end, "none"))
     {
         pos += 4;
         if (urlResult == SVGDocumentImpl::Result::kInvalid)
@@ -13,7 +13,8 @@ governing permissions and limitations under the License.
 #pragma once
 
 #include "SVGDocumentImpl.h"
-#include <functional>
+#include <array>
+#include <cstddef>
 #include <map>
 #include <string>
 
@@ -21,17 +22,26 @@ namespace SVGNative
 {
 namespace SVGStringParser
 {
-std::unique_ptr<Transform> ParseTransform(const std::string& transformString, std::function<std::unique_ptr<Transform>()> createTransform);
-bool ParseNumber(const std::string& numberString, float& number);
-bool ParseListOfNumbers(const std::string& numberListString, std::vector<float>& numberList, bool isAllOptional = true);
-bool ParseListOfLengthOrPercentage(
-    const std::string& lengthOrPercentageListString, float relDimensionLength, std::vector<float>& numberList, bool isAllOptional = true);
-bool ParseListOfStrings(const std::string& stringListString, std::vector<std::string>& stringList);
-bool ParseLengthOrPercentage(const std::string& lengthString, float relDimensionLength, float& absLengthInUnits, bool useQuirks = false);
-void ParsePathString(const std::string& pathString, Path& p);
-SVGDocumentImpl::Result ParseColor(const std::string& colorString, ColorImpl& paint, bool supportsCurrentColor = true);
-SVGDocumentImpl::Result ParsePaint(const std::string& colorString, const std::map<std::string, GradientImpl>& gradientMap,
-    const std::array<float, 4>& viewBox, PaintImpl& paint);
+// All functions parse the range [string, string + length). The range does not need to
+// be NUL-terminated.
+// Affine matrix {a, b, c, d, tx, ty} as passed to SVGRenderer::CreateTransform.
+using TransformMatrix = std::array<float, 6>;
+
+// Folds all functions of a transform list into matrix without allocating.
+bool ParseTransform(const char* transformString, size_t length, TransformMatrix& matrix);
+bool ParseNumber(const char* numberString, size_t length, float& number);
+bool ParseListOfNumbers(const char* numberListString, size_t length, std::vector<float>& numberList, bool isAllOptional = true);
+bool ParseListOfLengthOrPercentage(const char* lengthOrPercentageListString, size_t length, float relDimensionLength,
+    std::vector<float>& numberList, bool isAllOptional = true);
+bool ParseListOfStrings(const char* stringListString, size_t length, std::vector<std::string>& stringList);
+bool ParseLengthOrPercentage(
+    const char* lengthString, size_t length, float relDimensionLength, float& absLengthInUnits, bool useQuirks = false);
+void ParsePathString(const char* pathString, size_t length, Path& p);
+// Outline of the "points" attribute of polygon (isClosed) and polyline elements.
+void ParsePoints(const char* pointsString, size_t length, bool isClosed, Path& p);
+SVGDocumentImpl::Result ParseColor(const char* colorString, size_t length, ColorImpl& paint, bool supportsCurrentColor = true);
+SVGDocumentImpl::Result ParsePaint(const char* colorString, size_t length,
+    const std::map<std::string, std::shared_ptr<const GradientImpl>>& gradientMap, PaintImpl& paint);
 
 } // namespace SVGStringParser
 
@@ -0,0 +1,148 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "SVGParserBase64.h"
+#include "SVGRenderer.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using SVGNative::Base64Decoder;
+
+namespace
+{
+struct TestCase
+{
+    const char* name;
+    std::string base64;
+    bool isValid;
+    std::vector<unsigned char> bytes;
+};
+
+// Bytes 0, 3, 6, ... as encoded by the long test runs.
+std::vector<unsigned char> Multiples(size_t count)
+{
+    std::vector<unsigned char> bytes;
+    for (size_t i = 0; i < count; ++i)
+        bytes.push_back(static_cast<unsigned char>(i * 3));
+    return bytes;
+}
+
+const std::string gLongRun{"AAMGCQwPEhUYGx4hJCcqLTAzNjk8P0JFSEtOUVRXWl1gY2ZpbG9ydXh7foGEh4qNkJOWmZyfoqWoq66xtLe6vcDDxsnMz9LV2Nve4eTn6u3w8/b5/P8="};
+
+const std::vector<TestCase> gTestCases = {
+    {"empty", "", true, {}},
+    {"one byte padded", "QQ==", true, {'A'}},
+    {"two bytes padded", "QUI=", true, {'A', 'B'}},
+    {"three bytes", "QUJD", true, {'A', 'B', 'C'}},
+    {"one byte unpadded", "QQ", true, {'A'}},
+    {"two bytes unpadded", "QUI", true, {'A', 'B'}},
+    {"long run with padding", gLongRun, true, Multiples(86)},
+    {"long run without padding", gLongRun.substr(0, 112), true, Multiples(84)},
+    {"plus and slash", "//r18Ovm4dzX0s3Iw765tK+qpaCblpGM", true,
+        {255, 250, 245, 240, 235, 230, 225, 220, 215, 210, 205, 200, 195, 190, 185, 180, 175, 170, 165, 160, 155, 150, 145, 140}},
+    {"whitespace inside blocks", gLongRun.substr(0, 40) + "\n    " + gLongRun.substr(40, 40) + " \t" + gLongRun.substr(80), true,
+        Multiples(86)},
+    {"invalid character in the first block", "AAMGC-wP" + gLongRun.substr(8), false, {}},
+    {"invalid character in the second block", gLongRun.substr(0, 16) + "*" + gLongRun.substr(17), false, {}},
+    {"invalid character at the end", gLongRun.substr(0, 60) + "_", false, {}},
+    {"data after padding", "QUJDQUJDQUJDQUJDQUJDQQ==QUJD", false, {}},
+    {"single trailing digit", "QUJDQ", false, {}},
+    {"padding inside a block", gLongRun.substr(0, 32) + "=" + gLongRun.substr(33, 15), false, {}},
+    {"non-ASCII character", gLongRun.substr(0, 20) + "\xC3\xA9" + gLongRun.substr(20, 20), false, {}},
+};
+
+bool Decode(Base64Decoder decoder, const char* data, size_t length, std::vector<unsigned char>& output)
+{
+    output.resize(SVGNative::Base64DecodedSize(length));
+    size_t outputLength{};
+    if (!SVGNative::Base64Decode(decoder, data, length, output.data(), outputLength))
+        return false;
+    output.resize(outputLength);
+    return true;
+}
+
+// The SSSE3 decoder must agree with the scalar one on every substring, so that invalid
+// characters, whitespace and padding show up at all offsets of its 16 character blocks.
+bool AgreesOnSubstrings(const std::string& base64)
+{
+    for (size_t start = 0; start <= base64.size(); ++start)
+    {
+        for (size_t length = 0; start + length <= base64.size(); ++length)
+        {
+            std::vector<unsigned char> scalarBytes;
+            std::vector<unsigned char> ssse3Bytes;
+            bool isValid = Decode(Base64Decoder::kScalar, base64.data() + start, length, scalarBytes);
+            if (Decode(Base64Decoder::kSSSE3, base64.data() + start, length, ssse3Bytes) != isValid
+                || (isValid && ssse3Bytes != scalarBytes))
+                return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    int failures{};
+    auto fail = [&](const std::string& message) {
+        std::cout << "FAILED: " << message << std::endl;
+        ++failures;
+    };
+
+    bool hasSSSE3 = SVGNative::IsBase64DecoderAvailable(Base64Decoder::kSSSE3);
+    for (const auto& testCase : gTestCases)
+    {
+        std::vector<unsigned char> bytes;
+        bool isValid = Decode(Base64Decoder::kScalar, testCase.base64.data(), testCase.base64.size(), bytes);
+        if (isValid != testCase.isValid)
+            fail(std::string(testCase.name) + ": scalar decoder " + (isValid ? "accepts" : "rejects") + " the data");
+        else if (isValid && bytes != testCase.bytes)
+            fail(std::string(testCase.name) + ": scalar decoder gives the wrong bytes");
+
+        if (hasSSSE3 && !AgreesOnSubstrings(testCase.base64))
+            fail(std::string(testCase.name) + ": SSSE3 decoder differs from the scalar decoder");
+    }
+
+    // Random data with a bias towards the characters that end the SIMD fast path.
+    if (hasSSSE3)
+    {
+        static const std::string alphabet{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/= \n*\x80"};
+        std::mt19937 random(2019);
+        std::uniform_int_distribution<size_t> lengthDistribution(0, 80);
+        std::uniform_int_distribution<size_t> digitDistribution(0, 63);
+        std::uniform_int_distribution<size_t> charDistribution(0, alphabet.size() - 1);
+        std::uniform_int_distribution<int> rareDistribution(0, 39);
+        for (int i = 0; i < 2000; ++i)
+        {
+            std::string base64(lengthDistribution(random), 'A');
+            for (auto& c : base64)
+                c = alphabet[rareDistribution(random) ? digitDistribution(random) : charDistribution(random)];
+            std::vector<unsigned char> scalarBytes;
+            std::vector<unsigned char> ssse3Bytes;
+            bool isValid = Decode(Base64Decoder::kScalar, base64.data(), base64.size(), scalarBytes);
+            if (Decode(Base64Decoder::kSSSE3, base64.data(), base64.size(), ssse3Bytes) != isValid
+                || (isValid && ssse3Bytes != scalarBytes))
+            {
+                fail("SSSE3 decoder differs from the scalar decoder on \"" + base64 + "\"");
+                break;
+            }
+        }
+    }
+    else
+        std::cout << "SSSE3 decoder not available, only the scalar decoder was tested." << std::endl;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/*
+Copyright 2019 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+#include "CairoSVGRenderer.h"
+#include "CairoTiledRenderer.h"
+#include "SVGDocument.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace
+{
+// Owns a cairo image surface.
+struct Surface
+{
+    Surface(int width, int height)
+        : mSurface{cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height)}
+    {
+    }
+    ~Surface() { cairo_surface_destroy(mSurface); }
+    Surface(const Surface&) = delete;
+    Surface& operator=(const Surface&) = delete;
+
+    cairo_surface_t* mSurface;
+};
+
+bool IsSamePixels(cairo_surface_t* a, cairo_surface_t* b, int width, int height)
+{
+    cairo_surface_flush(a);
+    cairo_surface_flush(b);
+    auto stride = cairo_image_surface_get_stride(a);
+    auto data = cairo_image_surface_get_data(a);
+    auto otherStride = cairo_image_surface_get_stride(b);
+    auto otherData = cairo_image_surface_get_data(b);
+    for (int y = 0; y < height; ++y)
+    {
+        if (std::memcmp(data + y * stride, otherData + y * otherStride, 4 * static_cast<size_t>(width)) != 0)
+            return false;
+    }
+    return true;
+}
+
+// Renders the document once in one piece and then with RenderTiled(). Returns an error
+// message if the pixels differ, an empty string otherwise.
+std::string CheckTiled(const char* path, bool isLazy)
+{
+    SVGNative::ColorMap colorMap = {
+        {"test-red",   {{0.502,   0.0, 0.0, 1.0}}},
+        {"test-green", {{  0.0, 0.502, 0.0, 1.0}}},
+        {"test-blue",  {{  0.0,   0.0, 1.0, 1.0}}}
+    };
+
+    SVGNative::ParseOptions options;
+    options.computeBounds = true;
+    auto renderer = std::make_shared<SVGNative::CairoSVGRenderer>();
+    auto doc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(path, renderer, options);
+    if (!doc)
+        return "could not parse the document";
+    auto width = doc->Width();
+    auto height = doc->Height();
+    if (width <= 0 || height <= 0)
+        return std::string();
+
+    Surface surface(width, height);
+    auto cairo = cairo_create(surface.mSurface);
+    renderer->SetCairo(cairo);
+    doc->Render(doc->CompileColorMap(colorMap), static_cast<float>(width), static_cast<float>(height));
+    cairo_destroy(cairo);
+
+    // RenderTiled() builds lazy documents before the tiles start.
+    options.isLazy = isLazy;
+    auto tiledDoc = SVGNative::SVGDocument::CreateSVGDocumentFromFile(path, std::make_shared<SVGNative::CairoSVGRenderer>(), options);
+    if (!tiledDoc)
+        return "could not parse the document again";
+
+    // Small tiles, so that most elements cross tile boundaries.
+    Surface tiledSurface(width, height);
+    SVGNative::CairoTileOptions tileOptions;
+    tileOptions.tileSize = 16;
+    tileOptions.threadCount = 4;
+    if (!SVGNative::RenderTiled(*tiledDoc, tiledSurface.mSurface, tiledDoc->CompileColorMap(colorMap),
+        static_cast<float>(width), static_cast<float>(height), tileOptions))
+        return "RenderTiled() failed";
+
+    if (!IsSamePixels(surface.mSurface, tiledSurface.mSurface, width, height))
+        return "tiled rendering differs";
+    return std::string();
+}
+} // namespace
+
+// Usage: testTiledRenderer file...
+// Renders every file in one piece and in tiles on several threads. All pixels must agree.
+int main(int argc, char* const argv[])
+{
+    int failures{};
+    for (int i = 1; i < argc; ++i)
+    {
+        for (bool isLazy : {false, true})
+        {
+            auto error = CheckTiled(argv[i], isLazy);
+            if (!error.empty())
+            {
+                std::cout << "FAILED: " << argv[i] << (isLazy ? " (lazy): " : ": ") << error << std::endl;
+                ++failures;
+            }
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}